@@ -36,7 +36,13 @@
 #    "/home/kubo/Repos/SDDT-beta/src/hardware/hdl/ddr4_interface.v"
 #    "/home/kubo/Repos/SDDT-beta/src/hardware/hdl/ddr4_mc_odt.v"
 #    "/home/kubo/Repos/SDDT-beta/src/hardware/hdl/decoder.v"
+#    "/home/kubo/Repos/SDDT-beta/src/hardware/hdl/loop_engine.v"
 #    "/home/kubo/Repos/SDDT-beta/src/hardware/hdl/scheduler.v"
+#    "/home/kubo/Repos/SDDT-beta/src/hardware/hdl/pattern_tracker.v"
+#    "/home/kubo/Repos/SDDT-beta/src/hardware/hdl/pattern_pipe.v"
+#    "/home/kubo/Repos/SDDT-beta/src/hardware/hdl/wdata_pattern_gen.v"
+#    "/home/kubo/Repos/SDDT-beta/src/hardware/hdl/rdata_comparator.v"
+#    "/home/kubo/Repos/SDDT-beta/src/hardware/hdl/perf_counters.v"
 #    "/home/kubo/Repos/SDDT-beta/src/hardware/hdl/sddt_core.v"
 #    "/home/kubo/Repos/SDDT-beta/src/hardware/hdl/top.v"
 #    "/home/kubo/Repos/SDDT-beta/src/hardware/hdl/axis_keep_zero_mask.v"
@@ -67,7 +73,13 @@ proc checkRequiredFiles { origin_dir} {
  "[file normalize "$origin_dir/../src/hardware/hdl/ddr4_interface.v"]"\
  "[file normalize "$origin_dir/../src/hardware/hdl/ddr4_mc_odt.v"]"\
  "[file normalize "$origin_dir/../src/hardware/hdl/decoder.v"]"\
+ "[file normalize "$origin_dir/../src/hardware/hdl/loop_engine.v"]"\
  "[file normalize "$origin_dir/../src/hardware/hdl/scheduler.v"]"\
+ "[file normalize "$origin_dir/../src/hardware/hdl/pattern_tracker.v"]"\
+ "[file normalize "$origin_dir/../src/hardware/hdl/pattern_pipe.v"]"\
+ "[file normalize "$origin_dir/../src/hardware/hdl/wdata_pattern_gen.v"]"\
+ "[file normalize "$origin_dir/../src/hardware/hdl/rdata_comparator.v"]"\
+ "[file normalize "$origin_dir/../src/hardware/hdl/perf_counters.v"]"\
  "[file normalize "$origin_dir/../src/hardware/hdl/sddt_core.v"]"\
  "[file normalize "$origin_dir/../src/hardware/hdl/top.v"]"\
  "[file normalize "$origin_dir/../src/hardware/hdl/axis_keep_zero_mask.v"]"\
@@ -212,7 +224,13 @@ set files [list \
  [file normalize "${origin_dir}/../src/hardware/hdl/ddr4_interface.v"] \
  [file normalize "${origin_dir}/../src/hardware/hdl/ddr4_mc_odt.v"] \
  [file normalize "${origin_dir}/../src/hardware/hdl/decoder.v"] \
+ [file normalize "${origin_dir}/../src/hardware/hdl/loop_engine.v"] \
  [file normalize "${origin_dir}/../src/hardware/hdl/scheduler.v"] \
+ [file normalize "${origin_dir}/../src/hardware/hdl/pattern_tracker.v"] \
+ [file normalize "${origin_dir}/../src/hardware/hdl/pattern_pipe.v"] \
+ [file normalize "${origin_dir}/../src/hardware/hdl/wdata_pattern_gen.v"] \
+ [file normalize "${origin_dir}/../src/hardware/hdl/rdata_comparator.v"] \
+ [file normalize "${origin_dir}/../src/hardware/hdl/perf_counters.v"] \
  [file normalize "${origin_dir}/../src/hardware/hdl/sddt_core.v"] \
  [file normalize "${origin_dir}/../src/hardware/hdl/top.v"] \
  [file normalize "${origin_dir}/../src/hardware/hdl/axis_keep_zero_mask.v"] \
@@ -774,7 +792,8 @@ Port;FD4A0000;FD4AFFFF;1|FPD;DPDMA;FD4C0000;FD4CFFFF;1|FPD;DDR_XMPU5_CFG;FD05000
   set_property -dict [list \
     CONFIG.c_include_mm2s {1} \
     CONFIG.c_include_s2mm {1} \
-    CONFIG.c_include_sg {0} \
+    CONFIG.c_include_sg {1} \
+    CONFIG.c_sg_length_width {23} \
     CONFIG.c_m_axi_mm2s_data_width {512} \
     CONFIG.c_m_axis_mm2s_tdata_width {512} \
     CONFIG.c_micro_dma {0} \
@@ -796,7 +815,13 @@ Port;FD4A0000;FD4AFFFF;1|FPD;DPDMA;FD4C0000;FD4CFFFF;1|FPD;DDR_XMPU5_CFG;FD05000
 
   # Create instance: smartconnect_1, and set properties
   set smartconnect_1 [ create_bd_cell -type ip -vlnv xilinx.com:ip:smartconnect:1.0 smartconnect_1 ]
-  set_property CONFIG.NUM_SI {1} $smartconnect_1
+  set_property CONFIG.NUM_SI {2} $smartconnect_1
+
+
+  # Create instance: xlconcat_0, and set properties
+  # pl_ps_irq0[0] = MM2S, pl_ps_irq0[1] = S2MM (GIC SPI 89, 90)
+  set xlconcat_0 [ create_bd_cell -type ip -vlnv xilinx.com:ip:xlconcat:2.1 xlconcat_0 ]
+  set_property CONFIG.NUM_PORTS {2} $xlconcat_0
 
 
   # Create instance: smartconnect_2, and set properties
@@ -836,6 +861,7 @@ Port;FD4A0000;FD4AFFFF;1|FPD;DPDMA;FD4C0000;FD4CFFFF;1|FPD;DDR_XMPU5_CFG;FD05000
   connect_bd_intf_net -intf_net axi4_mm2s_bridge_128_0_M_AXIS [get_bd_intf_pins axi4_mm2s_bridge_128_0/M_AXIS] [get_bd_intf_pins axis_upsizer_32_128_0/s_axis]
   connect_bd_intf_net -intf_net axi_dma_0_M_AXIS_MM2S [get_bd_intf_ports M_AXIS_WDATA] [get_bd_intf_pins axi_dma_0/M_AXIS_MM2S]
   connect_bd_intf_net -intf_net axi_dma_0_M_AXI_MM2S [get_bd_intf_pins axi_dma_0/M_AXI_MM2S] [get_bd_intf_pins smartconnect_1/S00_AXI]
+  connect_bd_intf_net -intf_net axi_dma_0_M_AXI_SG [get_bd_intf_pins axi_dma_0/M_AXI_SG] [get_bd_intf_pins smartconnect_1/S01_AXI]
   connect_bd_intf_net -intf_net axi_dma_0_M_AXI_S2MM [get_bd_intf_pins axi_dma_0/M_AXI_S2MM] [get_bd_intf_pins axi_smc_1/S00_AXI]
   connect_bd_intf_net -intf_net axi_smc_1_M00_AXI [get_bd_intf_pins axi_smc_1/M00_AXI] [get_bd_intf_pins zynq_ultra_ps_e_0/S_AXI_HPC0_FPD]
   connect_bd_intf_net -intf_net axi_smc_M00_AXI [get_bd_intf_pins axi_smc/M00_AXI] [get_bd_intf_pins axi_dma_0/S_AXI_LITE]
@@ -848,7 +874,11 @@ Port;FD4A0000;FD4AFFFF;1|FPD;DPDMA;FD4C0000;FD4CFFFF;1|FPD;DDR_XMPU5_CFG;FD05000
   connect_bd_intf_net -intf_net zynq_ultra_ps_e_0_M_AXI_HPM1_FPD [get_bd_intf_pins zynq_ultra_ps_e_0/M_AXI_HPM1_FPD] [get_bd_intf_pins smartconnect_0/S00_AXI]
 
   # Create port connections
+  connect_bd_net -net axi_dma_0_mm2s_introut  [get_bd_pins axi_dma_0/mm2s_introut] \
+  [get_bd_pins xlconcat_0/In0]
   connect_bd_net -net axi_dma_0_s2mm_introut  [get_bd_pins axi_dma_0/s2mm_introut] \
+  [get_bd_pins xlconcat_0/In1]
+  connect_bd_net -net xlconcat_0_dout  [get_bd_pins xlconcat_0/dout] \
   [get_bd_pins zynq_ultra_ps_e_0/pl_ps_irq0]
   connect_bd_net -net axi_gpio_0_gpio2_io_o  [get_bd_pins axi_gpio_0/gpio2_io_o] \
   [get_bd_ports gpio2_io_o]
@@ -878,6 +908,7 @@ Port;FD4A0000;FD4AFFFF;1|FPD;DPDMA;FD4C0000;FD4CFFFF;1|FPD;DDR_XMPU5_CFG;FD05000
   [get_bd_pins zynq_ultra_ps_e_0/saxihpc0_fpd_aclk] \
   [get_bd_pins axi_smc/aclk] \
   [get_bd_pins axi_dma_0/m_axi_mm2s_aclk] \
+  [get_bd_pins axi_dma_0/m_axi_sg_aclk] \
   [get_bd_pins zynq_ultra_ps_e_0/saxihpc1_fpd_aclk] \
   [get_bd_pins smartconnect_1/aclk] \
   [get_bd_pins zynq_ultra_ps_e_0/maxihpm0_lpd_aclk] \
@@ -895,6 +926,9 @@ Port;FD4A0000;FD4AFFFF;1|FPD;DPDMA;FD4C0000;FD4CFFFF;1|FPD;DDR_XMPU5_CFG;FD05000
   assign_bd_address -offset 0x00000000 -range 0x80000000 -target_address_space [get_bd_addr_spaces axi_dma_0/Data_MM2S] [get_bd_addr_segs zynq_ultra_ps_e_0/SAXIGP1/HPC1_DDR_LOW] -force
   assign_bd_address -offset 0xFF000000 -range 0x01000000 -target_address_space [get_bd_addr_spaces axi_dma_0/Data_MM2S] [get_bd_addr_segs zynq_ultra_ps_e_0/SAXIGP1/HPC1_LPS_OCM] -force
   assign_bd_address -offset 0xC0000000 -range 0x20000000 -target_address_space [get_bd_addr_spaces axi_dma_0/Data_MM2S] [get_bd_addr_segs zynq_ultra_ps_e_0/SAXIGP1/HPC1_QSPI] -force
+  assign_bd_address -offset 0x00000000 -range 0x80000000 -target_address_space [get_bd_addr_spaces axi_dma_0/Data_SG] [get_bd_addr_segs zynq_ultra_ps_e_0/SAXIGP1/HPC1_DDR_LOW] -force
+  assign_bd_address -offset 0xFF000000 -range 0x01000000 -target_address_space [get_bd_addr_spaces axi_dma_0/Data_SG] [get_bd_addr_segs zynq_ultra_ps_e_0/SAXIGP1/HPC1_LPS_OCM] -force
+  assign_bd_address -offset 0xC0000000 -range 0x20000000 -target_address_space [get_bd_addr_spaces axi_dma_0/Data_SG] [get_bd_addr_segs zynq_ultra_ps_e_0/SAXIGP1/HPC1_QSPI] -force
   assign_bd_address -offset 0x00000000 -range 0x80000000 -target_address_space [get_bd_addr_spaces axi_dma_0/Data_S2MM] [get_bd_addr_segs zynq_ultra_ps_e_0/SAXIGP0/HPC0_DDR_LOW] -force
   assign_bd_address -offset 0xFF000000 -range 0x01000000 -target_address_space [get_bd_addr_spaces axi_dma_0/Data_S2MM] [get_bd_addr_segs zynq_ultra_ps_e_0/SAXIGP0/HPC0_LPS_OCM] -force
   assign_bd_address -offset 0xC0000000 -range 0x20000000 -target_address_space [get_bd_addr_spaces axi_dma_0/Data_S2MM] [get_bd_addr_segs zynq_ultra_ps_e_0/SAXIGP0/HPC0_QSPI] -force
@@ -923,9 +957,12 @@ preplace inst axi_smc_1 -pg 1 -lvl 3 -x 850 -y 80 -defaultsOSRD
 preplace inst axi_smc -pg 1 -lvl 1 -x 170 -y 360 -defaultsOSRD
 preplace inst smartconnect_1 -pg 1 -lvl 3 -x 850 -y 390 -defaultsOSRD
 preplace inst smartconnect_2 -pg 1 -lvl 5 -x 1800 -y 510 -defaultsOSRD
+preplace inst xlconcat_0 -pg 1 -lvl 3 -x 850 -y 220 -defaultsOSRD
 preplace inst axi4_mm2s_bridge_128_0 -pg 1 -lvl 6 -x 2150 -y 540 -defaultsOSRD
 preplace inst axis_upsizer_32_128_0 -pg 1 -lvl 7 -x 2460 -y 560 -defaultsOSRD
-preplace netloc axi_dma_0_s2mm_introut 1 2 2 710J 220 N
+preplace netloc axi_dma_0_mm2s_introut 1 2 1 700J 200n
+preplace netloc axi_dma_0_s2mm_introut 1 2 1 710J 220n
+preplace netloc xlconcat_0_dout 1 3 1 1000J 220n
 preplace netloc axi_gpio_0_gpio2_io_o 1 6 2 NJ 780 NJ
 preplace netloc rst_ps8_0_100M_peripheral_aresetn 1 0 8 30 280 310 420 700 310 NJ 310 1630 590 1970 620 2330 420 NJ
 preplace netloc zynq_ultra_ps_e_0_pl_clk0 1 0 8 20 260 320 430 690 170 1000 10 1650 290 1950 630 2340 640 NJ
@@ -31,6 +31,7 @@ module ddr4_adapter #(parameter CKE_WIDTH = 1, RANK_WIDTH = 1, DQ_WIDTH = 64, DR
   input [3:0]                ddr_ap,
   input [3:0]                ddr_half_bl,
   input [3:0]                ddr_pall,
+  input [3:0]                ddr_rank,
   input [4*`BG_WIDTH-1:0]    ddr_bg, 
   input [4*`BANK_WIDTH-1:0]  ddr_bank,
   input [4*`COL_WIDTH-1:0]   ddr_col,
@@ -65,7 +66,6 @@ module ddr4_adapter #(parameter CKE_WIDTH = 1, RANK_WIDTH = 1, DQ_WIDTH = 64, DR
   output                                            iss_dummy_read
   );
 
-  assign winRank  = 2'b0; // single rank -> tie to 0
   assign winBuf   = 4'b0; // TODO don't know how this could be used
   assign dBufAdr = {DATA_BUF_ADDR_WIDTH{1'b0}};
 
@@ -95,6 +95,7 @@ module ddr4_adapter #(parameter CKE_WIDTH = 1, RANK_WIDTH = 1, DQ_WIDTH = 64, DR
   reg                           WrCAS_ns, WrCAS_r;
 
   reg [1:0]                     mcCasSlot_r, mcCasSlot_ns;
+  reg [1:0]                     winRank_r, winRank_ns;
   reg                           gt_data_ready_r, gt_data_ready_ns;
   
   // TODO - PG 150 - page 180
@@ -111,6 +112,7 @@ module ddr4_adapter #(parameter CKE_WIDTH = 1, RANK_WIDTH = 1, DQ_WIDTH = 64, DR
 
   assign mcCasSlot  = mcCasSlot_r;
   assign mcCasSlot2 = mcCasSlot[1];
+  assign winRank    = winRank_r;
 
   assign wrDataMask = {DQ_WIDTH{1'b0}};
   assign mc_ACT_n   = ACT_n_r;
@@ -125,6 +127,7 @@ module ddr4_adapter #(parameter CKE_WIDTH = 1, RANK_WIDTH = 1, DQ_WIDTH = 64, DR
   integer adr_bit_i; // iterate over dfi address bits
   integer bank_bit_i; // iterate over bank number bits
   integer bg_bit_i; // iterate over bank group bits
+  integer cs_i; // chip select (rank) of the current command
   always@* begin
     wrDataBuf_ns = wrDataBuf;
     slot1_full_ns = slot1_full;
@@ -138,6 +141,7 @@ module ddr4_adapter #(parameter CKE_WIDTH = 1, RANK_WIDTH = 1, DQ_WIDTH = 64, DR
     RdCAS_ns = 1'b0;
     WrCAS_ns = 1'b0;
     mcCasSlot_ns = 2'b0;
+    winRank_ns = winRank_r;
     iss_dummy_read_ns = iss_dummy_read_r;
     read_will_be_dummy_ns = ddr_maint_read || read_will_be_dummy_r;
 
@@ -202,6 +206,8 @@ module ddr4_adapter #(parameter CKE_WIDTH = 1, RANK_WIDTH = 1, DQ_WIDTH = 64, DR
     // and hopefully convert those to Xilinx PHY
     // compatible commands.
     for(mc_cmd_i = 0 ; mc_cmd_i < DRAM_CMD_SLOTS ; mc_cmd_i = mc_cmd_i + 1) begin
+      // Rank select: CS_n[rank*8 + slot*2 +: 2] (rank 0 only on single-rank parts)
+      cs_i = (`CS_WIDTH > 1) ? ddr_rank[mc_cmd_i] : 0;
       if(ddr_nop[mc_cmd_i]) begin // NOP
          // set chip select to HI
         CS_n_ns[mc_cmd_i*1*2 +: 1*2] = {1*2{`HIGH}};
@@ -209,12 +215,13 @@ module ddr4_adapter #(parameter CKE_WIDTH = 1, RANK_WIDTH = 1, DQ_WIDTH = 64, DR
       else if(ddr_act[mc_cmd_i]) begin // Activate ROW
         // There seems to be something wrong with the dfi_cs signal widths
         // coming from the mc. Consider LSBs as valid CS signals for now
-        CS_n_ns[mc_cmd_i*1*2 +: 1*2] = {2*1{`LOW}};
+        CS_n_ns[cs_i*8 + mc_cmd_i*2 +: 2] = {2{`LOW}};
         ACT_n_ns[mc_cmd_i*2 +: 2] = {2{`LOW}};
       end // Activate
       else if(ddr_read[mc_cmd_i] || ddr_write[mc_cmd_i]) begin // DDR Read or Write
         mcCasSlot_ns = mc_cmd_i[0 +: 2];
-        CS_n_ns[mc_cmd_i*1*2 +: 1*2] = {2*1{`LOW}};
+        winRank_ns = cs_i[0 +: 2];
+        CS_n_ns[cs_i*8 + mc_cmd_i*2 +: 2] = {2{`LOW}};
         if(ddr_write[mc_cmd_i]) begin // Write burst
           ADR_ns[`ADDR_WIDTH*8-3*8 + mc_cmd_i*2 +: 2] = {2{`LOW}};  // WE
           ADR_ns[`ADDR_WIDTH*8-2*8 + mc_cmd_i*2 +: 2] = {2{`LOW}};  // CAS
@@ -232,19 +239,19 @@ module ddr4_adapter #(parameter CKE_WIDTH = 1, RANK_WIDTH = 1, DQ_WIDTH = 64, DR
         end
       end // DDR Read-Write
       else if(ddr_pre[mc_cmd_i]) begin // Precharge
-          CS_n_ns[mc_cmd_i*1*2 +: 1*2] = {2*1{`LOW}};
+          CS_n_ns[cs_i*8 + mc_cmd_i*2 +: 2] = {2{`LOW}};
           ADR_ns[`ADDR_WIDTH*8-3*8 + mc_cmd_i*2 +: 2] = {2{`LOW}};  // WE
           ADR_ns[`ADDR_WIDTH*8-2*8 + mc_cmd_i*2 +: 2] = {2{`HIGH}}; // ~CAS
           ADR_ns[`ADDR_WIDTH*8-8   + mc_cmd_i*2 +: 2] = {2{`LOW}};  // RAS
       end // Precharge
       else if(ddr_ref[mc_cmd_i]) begin // Refresh
-          CS_n_ns[mc_cmd_i*1*2 +: 1*2] = {2*1{`LOW}};
+          CS_n_ns[cs_i*8 + mc_cmd_i*2 +: 2] = {2{`LOW}};
           ADR_ns[`ADDR_WIDTH*8-3*8 + mc_cmd_i*2 +: 2] = {2{`HIGH}}; // ~WE
           ADR_ns[`ADDR_WIDTH*8-2*8 + mc_cmd_i*2 +: 2] = {2{`LOW}};  // CAS
           ADR_ns[`ADDR_WIDTH*8-8   + mc_cmd_i*2 +: 2] = {2{`LOW}};  // RAS
       end
       else if(ddr_zq[mc_cmd_i]) begin // ZQ Calib
-          CS_n_ns[mc_cmd_i*1*2 +: 1*2] = {2*1{`LOW}};
+          CS_n_ns[cs_i*8 + mc_cmd_i*2 +: 2] = {2{`LOW}};
           ADR_ns[`ADDR_WIDTH*8-3*8 + mc_cmd_i*2 +: 2] = {2{`LOW}};   // WE
           ADR_ns[`ADDR_WIDTH*8-2*8 + mc_cmd_i*2 +: 2] = {2{`HIGH}};  // ~CAS
           ADR_ns[`ADDR_WIDTH*8-8   + mc_cmd_i*2 +: 2] = {2{`HIGH}};  // ~RAS
@@ -311,6 +318,7 @@ module ddr4_adapter #(parameter CKE_WIDTH = 1, RANK_WIDTH = 1, DQ_WIDTH = 64, DR
       WrCAS_r <= 1'b0;
       RdCAS_r <= 1'b0;
       mcCasSlot_r <= 2'b0;
+      winRank_r <= 2'b0;
       slot1_full <= `LOW;
       slot2_full <= `LOW;
       gt_data_ready_r <= 1'b0;
@@ -334,6 +342,7 @@ module ddr4_adapter #(parameter CKE_WIDTH = 1, RANK_WIDTH = 1, DQ_WIDTH = 64, DR
         RdCAS_r <= RdCAS_ns;
         //fifo_wr_en_r <= fifo_wr_en_ns;
         mcCasSlot_r <= mcCasSlot_ns;
+        winRank_r <= winRank_ns;
         gt_data_ready_r <= gt_data_ready_ns;
       end
       else begin
@@ -352,6 +361,7 @@ module ddr4_adapter #(parameter CKE_WIDTH = 1, RANK_WIDTH = 1, DQ_WIDTH = 64, DR
         RdCAS_r <= 1'b0;
         //fifo_wr_en_r <= 1'b0;
         mcCasSlot_r <= 2'b0;
+        winRank_r <= 2'b0;
         gt_data_ready_r <= 1'b0;
       end
     end
@@ -52,6 +52,7 @@ module ddr4_interface #(
   input  wire [3:0]                ddr_nop,
   input  wire [3:0]                ddr_ap,
   input  wire [3:0]                ddr_pall,
+  input  wire [3:0]                ddr_rank,
   input  wire [3:0]                ddr_half_bl,
   input  wire [4*BG_WIDTH-1:0]     ddr_bg,
   input  wire [4*BANK_WIDTH-1:0]   ddr_bank,
@@ -295,6 +296,7 @@ module ddr4_interface #(
     .ddr_nop             (ddr_nop),
     .ddr_ap              (ddr_ap),
     .ddr_pall            (ddr_pall),
+    .ddr_rank            (ddr_rank),
     .ddr_half_bl         (ddr_half_bl),
     .ddr_bg              (ddr_bg),
     .ddr_bank            (ddr_bank),
@@ -11,11 +11,22 @@
 //   [639:128] - Write data (512-bit)
 //
 // DDR4 command format (each 32-bit slot):
-//   [2:0]   - Command type (0=NOP, 1=PRE, 2=ACT, 3=RD, 4=WR, 5=REF)
+//   [2:0]   - Command type (0=NOP, 1=PRE, 2=ACT, 3=RD, 4=WR, 5=REF, 6=ZQ, 7=WAIT)
 //   [4:3]   - Bank address
 //   [6:5]   - Bank group
 //   [23:7]  - Row address (for ACT) / Column address (for RD/WR)
 //   [7]     - PALL (precharge all) flag
+//   [19:17] - Pattern ID (for WR, data generated by the scheduler;
+//             for RD, data compared by the rdata_comparator)
+//   [24]    - Rank (PRE/ACT/RD/WR/REF/ZQ; PRE all banks and REF act on
+//             that rank only)
+//   [29:3]  - Idle cycle count (for WAIT, expanded by the scheduler)
+//   [29:10] - Register address/value (for WAIT with [30] set: CFG command)
+//   [30]    - Chain flag (for RD): more reads of the same batch follow, so
+//             the read data of this RD does not get TLAST
+//             CFG flag (for WAIT): configuration write, no idle cycles
+//             Reserved (must be 0) for the other commands
+//   [31]    - Strict flag (no packet boundary after this slot)
 //=============================================================================
 
 module decoder #(
@@ -45,6 +56,8 @@ module decoder #(
     output reg  [3:0]               ddr_ap,
     output reg  [3:0]               ddr_half_bl,
     output reg  [3:0]               ddr_pall,
+    output reg  [3:0]               ddr_rd_chain,
+    output reg  [3:0]               ddr_rank,
     output reg  [4*BG_WIDTH-1:0]    ddr_bg,
     output reg  [4*BANK_WIDTH-1:0]  ddr_bank,
     output reg  [4*COL_WIDTH-1:0]   ddr_col,
@@ -64,6 +77,7 @@ module decoder #(
     localparam CMD_WR   = 3'd4;
     localparam CMD_REF  = 3'd5;
     localparam CMD_ZQ   = 3'd6;
+    localparam CMD_WAIT = 3'd7;
 
     //=========================================================================
     // Internal signals
@@ -92,6 +106,8 @@ module decoder #(
             ddr_ap      <= 4'd0;
             ddr_half_bl <= 4'd0;
             ddr_pall    <= 4'd0;
+            ddr_rd_chain <= 4'd0;
+            ddr_rank    <= 4'd0;
             ddr_bg      <= {(4*BG_WIDTH){1'b0}};
             ddr_bank    <= {(4*BANK_WIDTH){1'b0}};
             ddr_col     <= {(4*COL_WIDTH){1'b0}};
@@ -109,6 +125,8 @@ module decoder #(
             ddr_ap      <= 4'd0;
             ddr_half_bl <= 4'd0;
             ddr_pall    <= 4'd0;
+            ddr_rd_chain <= 4'd0;
+            ddr_rank    <= 4'd0;
             ddr_bg      <= {(4*BG_WIDTH){1'b0}};
             ddr_bank    <= {(4*BANK_WIDTH){1'b0}};
             ddr_col     <= {(4*COL_WIDTH){1'b0}};
@@ -125,6 +143,7 @@ module decoder #(
                     ddr_bg[i*BG_WIDTH +: BG_WIDTH]       <= cmd_data[i*32+3+BANK_WIDTH +: BG_WIDTH];
                     ddr_row[i*ROW_WIDTH +: ROW_WIDTH]    <= cmd_data[i*32+3+BANK_WIDTH+BG_WIDTH +: ROW_WIDTH];
                     ddr_col[i*COL_WIDTH +: COL_WIDTH]    <= cmd_data[i*32+3+BANK_WIDTH+BG_WIDTH +: COL_WIDTH];
+                    ddr_rank[i]                          <= cmd_data[i*32+24];
                     
                     // Decode command type
                     case (cmd_data[i*32 +: 3])
@@ -134,10 +153,14 @@ module decoder #(
                             ddr_pall[i]  <= cmd_data[i*32+3+BANK_WIDTH+BG_WIDTH];
                         end
                         CMD_ACT: ddr_act[i]   <= 1'b1;
-                        CMD_RD:  ddr_read[i]  <= 1'b1;
+                        CMD_RD: begin
+                            ddr_read[i]     <= 1'b1;
+                            ddr_rd_chain[i] <= cmd_data[i*32+30];
+                        end
                         CMD_WR:  ddr_write[i] <= 1'b1;
                         CMD_REF: ddr_ref[i]   <= 1'b1;
                         CMD_ZQ:  ddr_zq[i]    <= 1'b1;
+                        CMD_WAIT: ddr_nop[i]  <= 1'b1; // Idle cycles are inserted by the scheduler
                         default: ddr_nop[i]   <= 1'b1;
                     endcase
                 end
@@ -0,0 +1,257 @@
+`timescale 1ns/1ps
+
+//=============================================================================
+// Loop Engine
+//
+// Sits between the command FIFO and the scheduler. Host command words are
+// forwarded unchanged until a program is started; the engine then runs the
+// program from its instruction memory (IMEM) and emits one command word per
+// cycle, with loop counters and bank/row/column counters in fabric, so loops
+// run at the command rate instead of the host MMIO rate.
+//
+// Behavior:
+//   - IMEM is loaded with CFG commands in the host stream (regs 2-6)
+//   - CFG reg 7 starts the program at the given address after the word
+//     that carries it has been forwarded
+//   - Host words are held back (TREADY low) while a program runs
+//   - HALT ends the program and toggles done_toggle
+//   - One instruction per cycle (IMEM_RD_LATENCY = 1, the next address is
+//     computed from the instruction being executed); SET, ADD, LOOP and
+//     JUMP emit no command word, so they add one idle cycle each
+//
+// CFG registers (WAIT opcode with [30] set, [29:26] address, [25:10] value):
+//   2 - IMEM write address (auto-increments after each instruction)
+//   3 - Instruction [15:0]
+//   4 - Instruction [31:16]
+//   5 - Instruction [47:32]
+//   6 - Instruction [63:48], writes the instruction to IMEM
+//   7 - Start the program at the value (IMEM address)
+//   At most one instruction can be written per command word.
+//
+// Instruction format (64-bit):
+//   [63:60] - Opcode (0=HALT, 1=CMD, 2=SET, 3=ADD, 4=LOOP, 5=JUMP)
+//   CMD:  [31:0]  command slot, emitted as {NOP, NOP, WAIT([56:32]), cmd},
+//                 so the next word follows 1 + [56:32] cycles later
+//         [57]    bank [6:3] <- BANK register
+//         [58]    row [23:7] <- ROW register (ACT)
+//         [59]    column [16:7] <- COL register (RD/WR)
+//   SET:  [50:48] register, [31:0] value
+//   ADD:  [50:48] register, [31:0] value added (BANK/ROW/COL wrap)
+//   LOOP: [50:48] counter register; decrements it and jumps to the target
+//         ([IMEM_ADDR_WIDTH-1:0]) unless it reaches zero
+//   JUMP: [IMEM_ADDR_WIDTH-1:0] target
+//
+// Registers: 0-3 = loop counters, 4 = BANK, 5 = ROW, 6 = COL
+//=============================================================================
+
+module loop_engine #(
+    parameter CMD_WIDTH       = 128,
+    parameter INSTR_WIDTH     = 64,
+    parameter IMEM_ADDR_WIDTH = 11,
+    parameter BANK_ADDR_WIDTH = 4,
+    parameter ROW_WIDTH       = 17
+)(
+    input  wire                     clk,
+    input  wire                     rst,
+
+    // AXI Stream Slave - host command words
+    input  wire [CMD_WIDTH-1:0]     S_AXIS_TDATA,
+    input  wire                     S_AXIS_TVALID,
+    output wire                     S_AXIS_TREADY,
+
+    // AXI Stream Master - command words to the scheduler
+    output reg  [CMD_WIDTH-1:0]     M_AXIS_TDATA,
+    output reg                      M_AXIS_TVALID,
+    input  wire                     M_AXIS_TREADY,
+
+    // Status
+    output reg                      running,
+    output reg                      done_toggle  // Toggles when a program halts
+);
+
+    //=========================================================================
+    // Encoding
+    //=========================================================================
+    localparam CMD_WAIT = 3'd7;
+
+    localparam CFG_IMEM_ADDR = 4'd2;
+    localparam CFG_INSTR_0   = 4'd3;
+    localparam CFG_INSTR_1   = 4'd4;
+    localparam CFG_INSTR_2   = 4'd5;
+    localparam CFG_INSTR_3   = 4'd6;
+    localparam CFG_START     = 4'd7;
+
+    localparam OP_HALT = 4'd0;
+    localparam OP_CMD  = 4'd1;
+    localparam OP_SET  = 4'd2;
+    localparam OP_ADD  = 4'd3;
+    localparam OP_LOOP = 4'd4;
+    localparam OP_JUMP = 4'd5;
+
+    localparam REG_BANK = 3'd4;
+    localparam REG_ROW  = 3'd5;
+    localparam REG_COL  = 3'd6;
+
+    localparam IMEM_DEPTH = 1 << IMEM_ADDR_WIDTH;
+
+    //=========================================================================
+    // Output handshake
+    //=========================================================================
+    wire out_free = !M_AXIS_TVALID || M_AXIS_TREADY;
+
+    assign S_AXIS_TREADY = !running && out_free;
+    wire pass_fire = S_AXIS_TVALID && S_AXIS_TREADY;
+
+    //=========================================================================
+    // CFG scan of host words (IMEM load, start)
+    //=========================================================================
+    reg [IMEM_ADDR_WIDTH-1:0] load_addr;
+    reg [INSTR_WIDTH-1:0]     load_instr;
+
+    reg [IMEM_ADDR_WIDTH-1:0] scan_addr;
+    reg [INSTR_WIDTH-1:0]     scan_instr;
+    reg                       imem_we;
+    reg [IMEM_ADDR_WIDTH-1:0] imem_wr_addr;
+    reg                       start;
+    reg [IMEM_ADDR_WIDTH-1:0] start_addr;
+    reg [31:0]                slot;
+    integer s;
+
+    always @(*) begin
+        scan_addr    = load_addr;
+        scan_instr   = load_instr;
+        imem_we      = 1'b0;
+        imem_wr_addr = load_addr;
+        start        = 1'b0;
+        start_addr   = {IMEM_ADDR_WIDTH{1'b0}};
+        for (s = 0; s < CMD_WIDTH/32; s = s + 1) begin
+            slot = S_AXIS_TDATA[s*32 +: 32];
+            if (slot[2:0] == CMD_WAIT && slot[30]) begin
+                case (slot[29:26])
+                    CFG_IMEM_ADDR: scan_addr = slot[10 +: IMEM_ADDR_WIDTH];
+                    CFG_INSTR_0:   scan_instr[15:0]  = slot[25:10];
+                    CFG_INSTR_1:   scan_instr[31:16] = slot[25:10];
+                    CFG_INSTR_2:   scan_instr[47:32] = slot[25:10];
+                    CFG_INSTR_3: begin
+                        scan_instr[63:48] = slot[25:10];
+                        imem_we      = 1'b1;
+                        imem_wr_addr = scan_addr;
+                        scan_addr    = scan_addr + 1'b1;
+                    end
+                    CFG_START: begin
+                        start      = 1'b1;
+                        start_addr = slot[10 +: IMEM_ADDR_WIDTH];
+                    end
+                    default: ;
+                endcase
+            end
+        end
+    end
+
+    //=========================================================================
+    // Instruction memory
+    //=========================================================================
+    reg [INSTR_WIDTH-1:0]     imem [0:IMEM_DEPTH-1];
+    reg [INSTR_WIDTH-1:0]     instr;       // Instruction at pc
+    reg                       instr_valid;
+    reg [IMEM_ADDR_WIDTH-1:0] pc;
+    reg                       imem_rd_en;
+    reg [IMEM_ADDR_WIDTH-1:0] imem_rd_addr;
+
+    always @(posedge clk) begin
+        if (pass_fire && imem_we)
+            imem[imem_wr_addr] <= scan_instr;
+        if (imem_rd_en)
+            instr <= imem[imem_rd_addr];
+    end
+
+    //=========================================================================
+    // Execute
+    //=========================================================================
+    reg [31:0] regs [0:7];
+
+    wire       exec = running && instr_valid && out_free;
+    wire [3:0] op   = instr[63:60];
+    wire [2:0] rsel = instr[50:48];
+    wire [31:0] loop_next = regs[rsel] - 1'b1;
+    wire [IMEM_ADDR_WIDTH-1:0] target = instr[IMEM_ADDR_WIDTH-1:0];
+
+    // Command slot with counter substitution
+    reg [31:0] cmd_slot;
+    always @(*) begin
+        cmd_slot = instr[31:0];
+        if (instr[57]) cmd_slot[3 +: BANK_ADDR_WIDTH] = regs[REG_BANK][BANK_ADDR_WIDTH-1:0];
+        if (instr[58]) cmd_slot[7 +: ROW_WIDTH]       = regs[REG_ROW][ROW_WIDTH-1:0];
+        if (instr[59]) cmd_slot[16:7]                 = regs[REG_COL][9:0];
+    end
+    wire [31:0] wait_slot = {4'd0, instr[56:32], CMD_WAIT};
+
+    reg [IMEM_ADDR_WIDTH-1:0] next_pc;
+    always @(*) begin
+        case (op)
+            OP_LOOP: next_pc = (loop_next != 32'd0) ? target : pc + 1'b1;
+            OP_JUMP: next_pc = target;
+            default: next_pc = pc + 1'b1;
+        endcase
+        if (pass_fire && start) begin
+            imem_rd_en   = 1'b1;
+            imem_rd_addr = start_addr;
+        end else begin
+            imem_rd_en   = exec && (op != OP_HALT);
+            imem_rd_addr = next_pc;
+        end
+    end
+
+    integer r;
+    always @(posedge clk) begin
+        if (rst) begin
+            M_AXIS_TDATA  <= {CMD_WIDTH{1'b0}};
+            M_AXIS_TVALID <= 1'b0;
+            running       <= 1'b0;
+            done_toggle   <= 1'b0;
+            instr_valid   <= 1'b0;
+            pc            <= {IMEM_ADDR_WIDTH{1'b0}};
+            load_addr     <= {IMEM_ADDR_WIDTH{1'b0}};
+            load_instr    <= {INSTR_WIDTH{1'b0}};
+            for (r = 0; r < 8; r = r + 1)
+                regs[r] <= 32'd0;
+        end else begin
+            if (M_AXIS_TVALID && M_AXIS_TREADY)
+                M_AXIS_TVALID <= 1'b0;
+
+            // Host words
+            if (pass_fire) begin
+                M_AXIS_TDATA  <= S_AXIS_TDATA;
+                M_AXIS_TVALID <= 1'b1;
+                load_addr     <= scan_addr;
+                load_instr    <= scan_instr;
+                if (start) begin
+                    running     <= 1'b1;
+                    instr_valid <= 1'b1;
+                    pc          <= start_addr;
+                end
+            end
+
+            // Program
+            if (exec) begin
+                pc <= next_pc;
+                case (op)
+                    OP_HALT: begin
+                        running     <= 1'b0;
+                        instr_valid <= 1'b0;
+                        done_toggle <= ~done_toggle;
+                    end
+                    OP_CMD: begin
+                        M_AXIS_TDATA  <= {{(CMD_WIDTH-64){1'b0}}, wait_slot, cmd_slot};
+                        M_AXIS_TVALID <= 1'b1;
+                    end
+                    OP_SET:  regs[rsel] <= instr[31:0];
+                    OP_ADD:  regs[rsel] <= regs[rsel] + instr[31:0];
+                    OP_LOOP: regs[rsel] <= loop_next;
+                    default: ;
+                endcase
+            end
+        end
+    end
+
+endmodule
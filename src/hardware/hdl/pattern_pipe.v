@@ -0,0 +1,116 @@
+`timescale 1ns/1ps
+
+//=============================================================================
+// Pattern Pipeline
+//
+// Computes the 512-bit data of a pattern in PIPE_STAGES (6) cycles, one FNV
+// multiply per stage, and carries a payload alongside. All stages advance
+// together when ce is high.
+//
+// Pattern IDs (word j = bits [32*j+31:32*j], i = column / 8):
+//   1 - FNV-1a hash of (rank, bank, row, seed, i, j), gen_data_pattern()
+//   2 - Solid:        seed
+//   3 - Checkerboard: (row ^ i ^ j) & 1 ? ~seed : seed
+//   4 - Row stripe:   row & 1 ? ~seed : seed
+//   Other IDs produce zero data.
+//=============================================================================
+
+module pattern_pipe #(
+    parameter WDATA_WIDTH = 512,
+    parameter PAYLOAD_WIDTH = 128,
+    parameter BANK_ADDR_WIDTH = 4,
+    parameter RANK_WIDTH = 1,
+    parameter ROW_WIDTH = 17
+)(
+    input  wire                       clk,
+    input  wire                       rst,
+    input  wire                       ce,
+
+    // Input
+    input  wire                       in_valid,
+    input  wire [PAYLOAD_WIDTH-1:0]   in_payload,
+    input  wire [2:0]                 pat_id,
+    input  wire [RANK_WIDTH-1:0]      rank,
+    input  wire [BANK_ADDR_WIDTH-1:0] bank,
+    input  wire [ROW_WIDTH-1:0]       row,
+    input  wire [9:0]                 col,
+    input  wire [31:0]                seed,
+
+    // Output (PIPE_STAGES cycles of ce later)
+    output wire                       out_valid,
+    output wire [PAYLOAD_WIDTH-1:0]   out_payload,
+    output wire [WDATA_WIDTH-1:0]     pattern
+);
+
+    localparam PAT_FNV     = 3'd1;
+    localparam PAT_SOLID   = 3'd2;
+    localparam PAT_CHECKER = 3'd3;
+    localparam PAT_ROW     = 3'd4;
+
+    localparam FNV_OFFSET = 32'd2166136261;
+    localparam FNV_PRIME  = 32'd16777619;
+
+    localparam N_WORDS     = WDATA_WIDTH / 32;
+    localparam PIPE_STAGES = 6;
+
+    reg  [PIPE_STAGES-1:0]     valid_pipe;
+    reg  [PAYLOAD_WIDTH-1:0]   payload_pipe [0:PIPE_STAGES-1];
+    reg  [2:0]                 pat_id_pipe  [0:PIPE_STAGES-2];
+    reg  [BANK_ADDR_WIDTH-1:0] bank_pipe    [0:PIPE_STAGES-2];
+    reg  [ROW_WIDTH-1:0]       row_pipe     [0:PIPE_STAGES-2];
+    reg  [6:0]                 i_pipe       [0:PIPE_STAGES-2];
+    reg  [31:0]                seed_pipe    [0:PIPE_STAGES-2];
+    reg  [31:0]                hash         [0:PIPE_STAGES-2];
+    reg  [WDATA_WIDTH-1:0]     pattern_reg;
+    integer k, j;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            valid_pipe <= {PIPE_STAGES{1'b0}};
+        end else if (ce) begin
+            valid_pipe <= {valid_pipe[PIPE_STAGES-2:0], in_valid};
+        end
+    end
+
+    always @(posedge clk) begin
+        if (ce) begin
+            // Stage 1: capture, hash = (offset ^ rank) * prime
+            payload_pipe[0] <= in_payload;
+            pat_id_pipe[0]  <= pat_id;
+            bank_pipe[0]    <= bank;
+            row_pipe[0]     <= row;
+            i_pipe[0]       <= col[9:3];
+            seed_pipe[0]    <= seed;
+            hash[0]         <= (FNV_OFFSET ^ {{(32-RANK_WIDTH){1'b0}}, rank}) * FNV_PRIME;
+            for (k = 1; k < PIPE_STAGES; k = k + 1)
+                payload_pipe[k] <= payload_pipe[k-1];
+            for (k = 1; k < PIPE_STAGES-1; k = k + 1) begin
+                pat_id_pipe[k] <= pat_id_pipe[k-1];
+                bank_pipe[k]   <= bank_pipe[k-1];
+                row_pipe[k]    <= row_pipe[k-1];
+                i_pipe[k]      <= i_pipe[k-1];
+                seed_pipe[k]   <= seed_pipe[k-1];
+            end
+            // Stages 2-5: bank, row, seed, i
+            hash[1] <= (hash[0] ^ {{(32-BANK_ADDR_WIDTH){1'b0}}, bank_pipe[0]}) * FNV_PRIME;
+            hash[2] <= (hash[1] ^ {{(32-ROW_WIDTH){1'b0}}, row_pipe[1]}) * FNV_PRIME;
+            hash[3] <= (hash[2] ^ seed_pipe[2]) * FNV_PRIME;
+            hash[4] <= (hash[3] ^ {25'd0, i_pipe[3]}) * FNV_PRIME;
+            // Stage 6: per-word step and the simple patterns
+            for (j = 0; j < N_WORDS; j = j + 1) begin
+                case (pat_id_pipe[4])
+                    PAT_FNV:     pattern_reg[j*32 +: 32] <= (hash[4] ^ j) * FNV_PRIME;
+                    PAT_SOLID:   pattern_reg[j*32 +: 32] <= seed_pipe[4];
+                    PAT_CHECKER: pattern_reg[j*32 +: 32] <= (row_pipe[4][0] ^ i_pipe[4][0] ^ j[0]) ? ~seed_pipe[4] : seed_pipe[4];
+                    PAT_ROW:     pattern_reg[j*32 +: 32] <= row_pipe[4][0] ? ~seed_pipe[4] : seed_pipe[4];
+                    default:     pattern_reg[j*32 +: 32] <= 32'd0;
+                endcase
+            end
+        end
+    end
+
+    assign out_valid   = valid_pipe[PIPE_STAGES-1];
+    assign out_payload = payload_pipe[PIPE_STAGES-1];
+    assign pattern     = pattern_reg;
+
+endmodule
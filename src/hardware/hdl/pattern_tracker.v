@@ -0,0 +1,119 @@
+`timescale 1ns/1ps
+
+//=============================================================================
+// Pattern Tracker
+//
+// Follows a 128-bit command stream and provides the pattern parameters of
+// the first TRACK_CMD (WR or RD) slot of each word.
+//
+// Behavior:
+//   - ACT slots update the open row of their (rank, bank)
+//   - CFG slots (WAIT with [30] set) update the pattern seed
+//   - Slots are applied in order, so an ACT or CFG earlier in the same word
+//     is visible to the tracked command
+//   - State is updated only when update is high
+//
+// Tracked command fields:
+//   [6:3]   - Bank address
+//   [16:7]  - Column address (i = column / 8)
+//   [19:17] - Pattern ID
+//   [24]    - Rank
+//
+// CFG command:
+//   [29:26] - Register address (0 = seed[15:0], 1 = seed[31:16])
+//   [25:10] - 16-bit value
+//=============================================================================
+
+module pattern_tracker #(
+    parameter CMD_WIDTH = 128,
+    parameter TRACK_CMD = 3'd4, // WR
+    parameter BANK_ADDR_WIDTH = 4,
+    parameter RANK_WIDTH = 1,
+    parameter ROW_WIDTH = 17
+)(
+    input  wire                       clk,
+    input  wire                       rst,
+
+    // Command word
+    input  wire [CMD_WIDTH-1:0]       cmd,
+    input  wire                       update,
+
+    // Tracked command of the word
+    output reg                        found,
+    output reg  [2:0]                 pat_id,
+    output reg  [RANK_WIDTH-1:0]      rank,
+    output reg  [BANK_ADDR_WIDTH-1:0] bank,
+    output reg  [ROW_WIDTH-1:0]       row,
+    output reg  [9:0]                 col,
+    output reg  [31:0]                seed
+);
+
+    //=========================================================================
+    // Command type encoding
+    //=========================================================================
+    localparam CMD_ACT  = 3'd2;
+    localparam CMD_WAIT = 3'd7;
+
+    localparam CFG_SEED_LO = 4'd0;
+    localparam CFG_SEED_HI = 4'd1;
+
+    // Open rows are kept per {rank, bank}
+    localparam N_BANKS = 1 << (RANK_WIDTH + BANK_ADDR_WIDTH);
+
+    //=========================================================================
+    // Slot scan
+    //=========================================================================
+    reg [ROW_WIDTH-1:0] open_row [0:N_BANKS-1];
+    reg [31:0]          cur_seed;
+
+    reg [ROW_WIDTH-1:0] scan_row [0:N_BANKS-1];
+    reg [31:0]          scan_seed;
+    reg [31:0]          slot;
+    integer s, b;
+
+    always @(*) begin
+        for (b = 0; b < N_BANKS; b = b + 1)
+            scan_row[b] = open_row[b];
+        scan_seed = cur_seed;
+        found  = 1'b0;
+        pat_id = 3'd0;
+        rank   = {RANK_WIDTH{1'b0}};
+        bank   = {BANK_ADDR_WIDTH{1'b0}};
+        row    = {ROW_WIDTH{1'b0}};
+        col    = 10'd0;
+        seed   = cur_seed;
+        for (s = 0; s < CMD_WIDTH/32; s = s + 1) begin
+            slot = cmd[s*32 +: 32];
+            if (slot[2:0] == CMD_ACT) begin
+                scan_row[{slot[24 +: RANK_WIDTH], slot[3 +: BANK_ADDR_WIDTH]}] = slot[7 +: ROW_WIDTH];
+            end else if (slot[2:0] == CMD_WAIT && slot[30]) begin
+                if (slot[29:26] == CFG_SEED_LO) scan_seed[15:0]  = slot[25:10];
+                if (slot[29:26] == CFG_SEED_HI) scan_seed[31:16] = slot[25:10];
+            end else if (slot[2:0] == TRACK_CMD && !found) begin
+                found  = 1'b1;
+                pat_id = slot[19:17];
+                rank   = slot[24 +: RANK_WIDTH];
+                bank   = slot[3 +: BANK_ADDR_WIDTH];
+                row    = scan_row[{slot[24 +: RANK_WIDTH], slot[3 +: BANK_ADDR_WIDTH]}];
+                col    = slot[16:7];
+                seed   = scan_seed;
+            end
+        end
+    end
+
+    //=========================================================================
+    // State update
+    //=========================================================================
+    always @(posedge clk) begin
+        if (rst) begin
+            for (b = 0; b < N_BANKS; b = b + 1)
+                open_row[b] <= {ROW_WIDTH{1'b0}};
+            cur_seed <= 32'd0;
+        end else if (update) begin
+            for (b = 0; b < N_BANKS; b = b + 1)
+                open_row[b] <= scan_row[b];
+            cur_seed <= scan_seed;
+        end
+    end
+
+endmodule
@@ -0,0 +1,133 @@
+`timescale 1ns/1ps
+
+//=============================================================================
+// Performance Counters
+//
+// Always-on 64-bit event counters with snapshot and clear, read one 32-bit
+// half at a time through the GPIO state window.
+//
+// Behavior:
+//   - Counter n adds inc[3*n+2:3*n] every cycle (up to 4 events per cycle)
+//   - A rising edge on snapshot copies all counters to the shadow registers
+//   - A rising edge on clear resets all counters (not the shadows)
+//   - data = half index[0] (0 = low, 1 = high) of shadow counter index[5:1],
+//     so the host reads a consistent set while counting goes on
+//
+// Issue window:
+//   - Counters N_COUNTERS and N_COUNTERS+1 are the DRAM cycles (fabric
+//     cycle * 4 + slot) of the first and last non-NOP command issued since
+//     the last clear or mark, so last - first + 1 is the achieved nCK
+//   - mark restarts the window in command order (CFG in the stream, aligned
+//     with issue by the caller)
+//=============================================================================
+
+module perf_counters #(
+    parameter N_COUNTERS = 16
+)(
+    input  wire                      clk,
+    input  wire                      rst,
+
+    // Events
+    input  wire [N_COUNTERS*3-1:0]   inc,
+    input  wire [3:0]                issue,    // Non-NOP command per slot
+    input  wire                      mark,     // Restart the issue window
+
+    // Control (levels, edges are detected here)
+    input  wire                      snapshot,
+    input  wire                      clear,
+
+    // Read window
+    input  wire [5:0]                index,
+    output reg  [31:0]               data
+);
+
+    localparam N_SHADOWS = N_COUNTERS + 2;
+
+    reg [63:0] count  [0:N_COUNTERS-1];
+    reg [63:0] shadow [0:N_SHADOWS-1];
+    reg        snapshot_r;
+    reg        clear_r;
+    integer n;
+
+    wire snapshot_edge = snapshot && !snapshot_r;
+    wire clear_edge    = clear && !clear_r;
+
+    //=========================================================================
+    // Issue window
+    //=========================================================================
+    reg [61:0] time_cnt;     // Free-running fabric cycle counter
+    reg [63:0] first_issue;
+    reg [63:0] last_issue;
+    reg        window_open;  // first_issue is valid
+
+    // First and last issuing slot of the word
+    reg [1:0] first_slot;
+    reg [1:0] last_slot;
+    integer k;
+    always @(*) begin
+        first_slot = 2'd0;
+        last_slot  = 2'd0;
+        for (k = 3; k >= 0; k = k - 1)
+            if (issue[k]) first_slot = k;
+        for (k = 0; k < 4; k = k + 1)
+            if (issue[k]) last_slot = k;
+    end
+
+    always @(posedge clk) begin
+        if (rst) begin
+            time_cnt    <= 62'd0;
+            first_issue <= 64'd0;
+            last_issue  <= 64'd0;
+            window_open <= 1'b0;
+        end else begin
+            time_cnt <= time_cnt + 1'b1;
+            if (clear_edge || mark) begin
+                // The word issued with the mark opens the new window
+                first_issue <= (|issue) ? {time_cnt, first_slot} : 64'd0;
+                last_issue  <= (|issue) ? {time_cnt, last_slot}  : 64'd0;
+                window_open <= |issue;
+            end else if (|issue) begin
+                if (!window_open) begin
+                    first_issue <= {time_cnt, first_slot};
+                    window_open <= 1'b1;
+                end
+                last_issue <= {time_cnt, last_slot};
+            end
+        end
+    end
+
+    always @(posedge clk) begin
+        if (rst) begin
+            snapshot_r <= 1'b0;
+            clear_r    <= 1'b0;
+            for (n = 0; n < N_COUNTERS; n = n + 1)
+                count[n] <= 64'd0;
+            for (n = 0; n < N_SHADOWS; n = n + 1)
+                shadow[n] <= 64'd0;
+        end else begin
+            snapshot_r <= snapshot;
+            clear_r    <= clear;
+            for (n = 0; n < N_COUNTERS; n = n + 1) begin
+                if (clear_edge)
+                    count[n] <= 64'd0;
+                else
+                    count[n] <= count[n] + inc[3*n +: 3];
+                if (snapshot_edge)
+                    shadow[n] <= count[n];
+            end
+            if (snapshot_edge) begin
+                shadow[N_COUNTERS]   <= first_issue;
+                shadow[N_COUNTERS+1] <= last_issue;
+            end
+        end
+    end
+
+    // Registered read mux (the state path is synchronized anyway)
+    always @(posedge clk) begin
+        if (index[5:1] < N_SHADOWS)
+            data <= index[0] ? shadow[index[5:1]][63:32] : shadow[index[5:1]][31:0];
+        else
+            data <= 32'd0;
+    end
+
+endmodule
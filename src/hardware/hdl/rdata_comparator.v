@@ -0,0 +1,385 @@
+`timescale 1ns/1ps
+
+//=============================================================================
+// Read Data Comparator
+//
+// Sits between the DDR4 read data (rdData) and the RDATA FIFO. Read beats of
+// compare RDs are checked against the pattern generated in fabric and only
+// mismatch records plus one summary per batch are streamed to the host.
+// Read beats of plain RDs pass through unchanged.
+//
+// Behavior:
+//   - pattern_tracker follows the scheduler output (ACT rows, CFG seed) and
+//     queues a descriptor for every RD word, popped when its data returns
+//   - pattern_pipe regenerates the expected data of the beat (same pattern
+//     IDs as wdata_pattern_gen)
+//   - A compare beat with flipped bits produces a mismatch record; the last
+//     compare beat of a batch (TLAST) produces a summary beat with TLAST
+//   - Records are buffered in an ENTRY_DEPTH FIFO and serialized at one beat
+//     per cycle. If the FIFO is nearly full, mismatch records are dropped
+//     and counted (the summary is always sent)
+//   - A batch should contain only compare RDs or only plain RDs
+//
+// RD compare fields:
+//   [19:17] - Pattern ID (0 = plain RD, data is forwarded)
+//
+// Output beats (word k = bits [32*k+31:32*k]):
+//   Mismatch header: word0 = 1, word1 = bank, word2 = row, word3 = column,
+//                    word4 = flipped bits of the beat
+//   Mismatch mask:   read data XOR expected data (follows the header)
+//   Summary (TLAST): word0 = 2, word1 = beats compared,
+//                    word2 = mismatched beats, word3 = flipped bits,
+//                    word4 = dropped mismatch records
+//=============================================================================
+
+module rdata_comparator #(
+    parameter CMD_WIDTH   = 128,
+    parameter DATA_WIDTH  = 512,
+    parameter BANK_ADDR_WIDTH = 4,
+    parameter ROW_WIDTH   = 17,
+    parameter DESC_DEPTH  = 64,  // > max reads in flight
+    parameter ENTRY_DEPTH = 32
+)(
+    input  wire                     clk,
+    input  wire                     rst,
+
+    // Command words as output by the scheduler
+    input  wire [CMD_WIDTH-1:0]     cmd_data,
+    input  wire                     cmd_valid,
+
+    // Read data from the DDR4 interface
+    input  wire [DATA_WIDTH-1:0]    rd_data,
+    input  wire                     rd_data_en,
+    input  wire                     rd_data_last,
+
+    // Output stream (no backpressure, like rdData)
+    output reg  [DATA_WIDTH-1:0]    m_tdata,
+    output reg                      m_tlast,
+    output reg                      m_tvalid
+);
+
+    localparam CMD_RD   = 3'd3;
+    localparam PAT_HOST = 3'd0;
+
+    localparam DESC_PTR_WIDTH  = $clog2(DESC_DEPTH);
+    localparam ENTRY_PTR_WIDTH = $clog2(ENTRY_DEPTH);
+    localparam ENTRY_RESERVE   = 8; // Entries kept free for data and summaries
+
+    localparam N_WORDS = DATA_WIDTH / 32;
+
+    localparam KIND_DATA     = 2'd0;
+    localparam KIND_MISMATCH = 2'd1;
+    localparam KIND_SUMMARY  = 2'd2;
+
+    //=========================================================================
+    // RD descriptor queue
+    //=========================================================================
+    wire                       rd_found;
+    wire [2:0]                 rd_pat_id;
+    wire                       rd_rank;
+    wire [BANK_ADDR_WIDTH-1:0] rd_bank;
+    wire [ROW_WIDTH-1:0]       rd_row;
+    wire [9:0]                 rd_col;
+    wire [31:0]                rd_seed;
+
+    pattern_tracker #(
+        .CMD_WIDTH(CMD_WIDTH),
+        .TRACK_CMD(CMD_RD),
+        .BANK_ADDR_WIDTH(BANK_ADDR_WIDTH),
+        .ROW_WIDTH(ROW_WIDTH)
+    ) pattern_tracker_inst (
+        .clk(clk),
+        .rst(rst),
+        .cmd(cmd_data),
+        .update(cmd_valid),
+        .found(rd_found),
+        .pat_id(rd_pat_id),
+        .rank(rd_rank),
+        .bank(rd_bank),
+        .row(rd_row),
+        .col(rd_col),
+        .seed(rd_seed)
+    );
+
+    // Read data returns in the order the RDs were issued (one RD per word)
+    reg [2:0]                 desc_pat_id [0:DESC_DEPTH-1];
+    reg                       desc_rank   [0:DESC_DEPTH-1];
+    reg [BANK_ADDR_WIDTH-1:0] desc_bank   [0:DESC_DEPTH-1];
+    reg [ROW_WIDTH-1:0]       desc_row    [0:DESC_DEPTH-1];
+    reg [9:0]                 desc_col    [0:DESC_DEPTH-1];
+    reg [31:0]                desc_seed   [0:DESC_DEPTH-1];
+    reg [DESC_PTR_WIDTH-1:0]  desc_wr_ptr;
+    reg [DESC_PTR_WIDTH-1:0]  desc_rd_ptr;
+
+    always @(posedge clk) begin
+        if (cmd_valid && rd_found) begin
+            desc_pat_id[desc_wr_ptr] <= rd_pat_id;
+            desc_rank[desc_wr_ptr]   <= rd_rank;
+            desc_bank[desc_wr_ptr]   <= rd_bank;
+            desc_row[desc_wr_ptr]    <= rd_row;
+            desc_col[desc_wr_ptr]    <= rd_col;
+            desc_seed[desc_wr_ptr]   <= rd_seed;
+        end
+    end
+
+    always @(posedge clk) begin
+        if (rst) begin
+            desc_wr_ptr <= {DESC_PTR_WIDTH{1'b0}};
+            desc_rd_ptr <= {DESC_PTR_WIDTH{1'b0}};
+        end else begin
+            if (cmd_valid && rd_found)
+                desc_wr_ptr <= desc_wr_ptr + 1'b1;
+            if (rd_data_en)
+                desc_rd_ptr <= desc_rd_ptr + 1'b1;
+        end
+    end
+
+    //=========================================================================
+    // Expected data
+    //=========================================================================
+    // Payload: {compare, last, bank, row, col, read data}
+    localparam PAYLOAD_WIDTH = 2 + BANK_ADDR_WIDTH + ROW_WIDTH + 10 + DATA_WIDTH;
+
+    wire [2:0]                 beat_pat_id = desc_pat_id[desc_rd_ptr];
+    wire                       exp_valid;
+    wire [PAYLOAD_WIDTH-1:0]   exp_payload;
+    wire [DATA_WIDTH-1:0]      exp_data;
+
+    pattern_pipe #(
+        .WDATA_WIDTH(DATA_WIDTH),
+        .PAYLOAD_WIDTH(PAYLOAD_WIDTH),
+        .BANK_ADDR_WIDTH(BANK_ADDR_WIDTH),
+        .ROW_WIDTH(ROW_WIDTH)
+    ) pattern_pipe_inst (
+        .clk(clk),
+        .rst(rst),
+        .ce(1'b1),
+        .in_valid(rd_data_en),
+        .in_payload({beat_pat_id != PAT_HOST, rd_data_last, desc_bank[desc_rd_ptr],
+                     desc_row[desc_rd_ptr], desc_col[desc_rd_ptr], rd_data}),
+        .pat_id(beat_pat_id),
+        .rank(desc_rank[desc_rd_ptr]),
+        .bank(desc_bank[desc_rd_ptr]),
+        .row(desc_row[desc_rd_ptr]),
+        .col(desc_col[desc_rd_ptr]),
+        .seed(desc_seed[desc_rd_ptr]),
+        .out_valid(exp_valid),
+        .out_payload(exp_payload),
+        .pattern(exp_data)
+    );
+
+    //=========================================================================
+    // Compare (XOR, per-word popcount, beat popcount)
+    //=========================================================================
+    function [5:0] popcount32;
+        input [31:0] w;
+        integer n;
+        begin
+            popcount32 = 6'd0;
+            for (n = 0; n < 32; n = n + 1)
+                popcount32 = popcount32 + w[n];
+        end
+    endfunction
+
+    localparam META_WIDTH = BANK_ADDR_WIDTH + ROW_WIDTH + 10;
+
+    // Stage A: XOR
+    reg                   a_valid, a_cmp, a_last;
+    reg [META_WIDTH-1:0]  a_meta;
+    reg [DATA_WIDTH-1:0]  a_data;   // XOR mask for compare beats
+    // Stage B: per-word popcount
+    reg                   b_valid, b_cmp, b_last;
+    reg [META_WIDTH-1:0]  b_meta;
+    reg [DATA_WIDTH-1:0]  b_data;
+    reg [5:0]             b_word_flips [0:N_WORDS-1];
+    // Stage C: beat popcount
+    reg                   c_valid, c_cmp, c_last;
+    reg [META_WIDTH-1:0]  c_meta;
+    reg [DATA_WIDTH-1:0]  c_data;
+    reg [15:0]            c_flips;
+
+    reg [15:0] beat_flips;
+    integer j;
+
+    always @(*) begin
+        beat_flips = 16'd0;
+        for (j = 0; j < N_WORDS; j = j + 1)
+            beat_flips = beat_flips + b_word_flips[j];
+    end
+
+    always @(posedge clk) begin
+        if (rst) begin
+            a_valid <= 1'b0;
+            b_valid <= 1'b0;
+            c_valid <= 1'b0;
+        end else begin
+            a_valid <= exp_valid;
+            b_valid <= a_valid;
+            c_valid <= b_valid;
+        end
+    end
+
+    always @(posedge clk) begin
+        a_cmp  <= exp_payload[PAYLOAD_WIDTH-1];
+        a_last <= exp_payload[PAYLOAD_WIDTH-2];
+        a_meta <= exp_payload[DATA_WIDTH +: META_WIDTH];
+        a_data <= exp_payload[PAYLOAD_WIDTH-1] ? (exp_payload[DATA_WIDTH-1:0] ^ exp_data)
+                                               : exp_payload[DATA_WIDTH-1:0];
+
+        b_cmp  <= a_cmp;
+        b_last <= a_last;
+        b_meta <= a_meta;
+        b_data <= a_data;
+        for (j = 0; j < N_WORDS; j = j + 1)
+            b_word_flips[j] <= a_cmp ? popcount32(a_data[j*32 +: 32]) : 6'd0;
+
+        c_cmp   <= b_cmp;
+        c_last  <= b_last;
+        c_meta  <= b_meta;
+        c_data  <= b_data;
+        c_flips <= beat_flips;
+    end
+
+    //=========================================================================
+    // Batch counters and record entries
+    //=========================================================================
+    reg [31:0] cnt_beats;
+    reg [31:0] cnt_mismatch;
+    reg [31:0] cnt_flips;
+    reg [31:0] cnt_dropped;
+
+    // Entry: {kind, last, summary follows, summary, meta, flips, data}
+    localparam ENTRY_WIDTH = 2 + 1 + 1 + 128 + META_WIDTH + 16 + DATA_WIDTH;
+
+    reg  [ENTRY_WIDTH-1:0]     entry_mem [0:ENTRY_DEPTH-1];
+    reg  [ENTRY_PTR_WIDTH-1:0] entry_wr_ptr;
+    reg  [ENTRY_PTR_WIDTH-1:0] entry_rd_ptr;
+    reg  [ENTRY_PTR_WIDTH:0]   entry_count;
+
+    wire c_mismatch = c_cmp && (c_flips != 16'd0);
+    wire entry_room = (entry_count < ENTRY_DEPTH - ENTRY_RESERVE);
+    wire c_drop     = c_mismatch && !entry_room;
+    wire c_summary  = c_cmp && c_last;
+
+    // Counters including the current beat (for its summary)
+    wire [31:0] sum_beats    = cnt_beats + 1'b1;
+    wire [31:0] sum_mismatch = cnt_mismatch + c_mismatch;
+    wire [31:0] sum_flips    = cnt_flips + c_flips;
+    wire [31:0] sum_dropped  = cnt_dropped + c_drop;
+
+    reg  entry_push;
+    reg  [ENTRY_WIDTH-1:0] entry_in;
+    wire entry_pop;
+
+    always @(*) begin
+        entry_push = 1'b0;
+        entry_in   = {ENTRY_WIDTH{1'b0}};
+        if (c_valid) begin
+            if (!c_cmp) begin
+                entry_push = 1'b1;
+                entry_in   = {KIND_DATA, c_last, 1'b0, 128'd0, c_meta, 16'd0, c_data};
+            end else if (c_mismatch && !c_drop) begin
+                entry_push = 1'b1;
+                entry_in   = {KIND_MISMATCH, 1'b0, c_summary,
+                              sum_dropped, sum_flips, sum_mismatch, sum_beats,
+                              c_meta, c_flips, c_data};
+            end else if (c_summary) begin
+                entry_push = 1'b1;
+                entry_in   = {KIND_SUMMARY, 1'b1, 1'b1,
+                              sum_dropped, sum_flips, sum_mismatch, sum_beats,
+                              c_meta, 16'd0, {DATA_WIDTH{1'b0}}};
+            end
+        end
+    end
+
+    always @(posedge clk) begin
+        if (entry_push)
+            entry_mem[entry_wr_ptr] <= entry_in;
+    end
+
+    always @(posedge clk) begin
+        if (rst) begin
+            cnt_beats    <= 32'd0;
+            cnt_mismatch <= 32'd0;
+            cnt_flips    <= 32'd0;
+            cnt_dropped  <= 32'd0;
+            entry_wr_ptr <= {ENTRY_PTR_WIDTH{1'b0}};
+            entry_rd_ptr <= {ENTRY_PTR_WIDTH{1'b0}};
+            entry_count  <= {(ENTRY_PTR_WIDTH+1){1'b0}};
+        end else begin
+            if (c_valid && c_cmp) begin
+                if (c_summary) begin
+                    cnt_beats    <= 32'd0;
+                    cnt_mismatch <= 32'd0;
+                    cnt_flips    <= 32'd0;
+                    cnt_dropped  <= 32'd0;
+                end else begin
+                    cnt_beats    <= sum_beats;
+                    cnt_mismatch <= sum_mismatch;
+                    cnt_flips    <= sum_flips;
+                    cnt_dropped  <= sum_dropped;
+                end
+            end
+            if (entry_push)
+                entry_wr_ptr <= entry_wr_ptr + 1'b1;
+            if (entry_pop)
+                entry_rd_ptr <= entry_rd_ptr + 1'b1;
+            entry_count <= entry_count + entry_push - entry_pop;
+        end
+    end
+
+    //=========================================================================
+    // Output serializer
+    //=========================================================================
+    wire [ENTRY_WIDTH-1:0] head = entry_mem[entry_rd_ptr];
+    wire [DATA_WIDTH-1:0]  head_data    = head[DATA_WIDTH-1:0];
+    wire [15:0]            head_flips   = head[DATA_WIDTH +: 16];
+    wire [META_WIDTH-1:0]  head_meta    = head[DATA_WIDTH+16 +: META_WIDTH];
+    wire [127:0]           head_summary = head[DATA_WIDTH+16+META_WIDTH +: 128];
+    wire                   head_sum     = head[ENTRY_WIDTH-4];
+    wire                   head_last    = head[ENTRY_WIDTH-3];
+    wire [1:0]             head_kind    = head[ENTRY_WIDTH-1 -: 2];
+
+    wire [9:0]                 head_col  = head_meta[9:0];
+    wire [ROW_WIDTH-1:0]       head_row  = head_meta[10 +: ROW_WIDTH];
+    wire [BANK_ADDR_WIDTH-1:0] head_bank = head_meta[10+ROW_WIDTH +: BANK_ADDR_WIDTH];
+
+    // Beat of the head entry: 0 = header / data / summary, 1 = mask, 2 = summary
+    reg  [1:0] phase;
+    wire       entry_valid = (entry_count != {(ENTRY_PTR_WIDTH+1){1'b0}});
+    wire       head_done = (head_kind != KIND_MISMATCH) ||
+                           (phase == 2'd1 && !head_sum) ||
+                           (phase == 2'd2);
+    assign entry_pop = entry_valid && head_done;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            phase    <= 2'd0;
+            m_tvalid <= 1'b0;
+            m_tlast  <= 1'b0;
+            m_tdata  <= {DATA_WIDTH{1'b0}};
+        end else begin
+            m_tvalid <= entry_valid;
+            if (entry_valid) begin
+                phase <= head_done ? 2'd0 : phase + 1'b1;
+                if (head_kind == KIND_DATA) begin
+                    m_tdata <= head_data;
+                    m_tlast <= head_last;
+                end else if (head_kind == KIND_SUMMARY || phase == 2'd2) begin
+                    m_tdata <= {{(DATA_WIDTH-160){1'b0}}, head_summary, 32'd2};
+                    m_tlast <= 1'b1;
+                end else if (phase == 2'd0) begin
+                    m_tdata <= {{(DATA_WIDTH-160){1'b0}}, 16'd0, head_flips,
+                                22'd0, head_col,
+                                {(32-ROW_WIDTH){1'b0}}, head_row,
+                                {(32-BANK_ADDR_WIDTH){1'b0}}, head_bank, 32'd1};
+                    m_tlast <= 1'b0;
+                end else begin
+                    m_tdata <= head_data;
+                    m_tlast <= 1'b0;
+                end
+            end
+        end
+    end
+
+endmodule
@@ -15,6 +15,17 @@
 // This design allows wdata to be pre-loaded before the WR command arrives,
 // minimizing latency.
 //
+// Pattern WR:
+//   - Command words first pass through wdata_pattern_gen, which generates
+//     the write data of WRs with a non-zero pattern ID ([19:17]) in fabric
+//   - Such a WR uses the generated data and does not consume host wdata
+//
+// WAIT command:
+//   - A slot with opcode 7 (WAIT) is sent to the decoder as a NOP and then
+//     holds the next command word back for WAIT count fabric cycles, so N
+//     idle cycles cost one 32-bit word instead of N NOP words.
+//   - WAIT with count 0 is a plain NOP (legacy 0b111 NOP words).
+//
 // Input format:
 //   - S_AXIS_CMD 128-bit DDR4 command data (4 x 32-bit commands)
 //   - S_AXIS_WDATA: 512-bit write data
@@ -49,18 +60,53 @@ module scheduler #(
 
     // Debug interface
     input  wire [1:0]               debug_index,
-    output wire [31:0]              debug_data
+    output wire [31:0]              debug_data,
+
+    // Performance events (one cycle each, see perf_counters)
+    output wire [6:0]               perf_events,
+
+    // A command word is held (pattern generator, scheduler or WAIT idle)
+    output wire                     busy
 );
 
     //=========================================================================
     // Command type encoding
     //=========================================================================
-    localparam CMD_WR = 3'd4;
+    localparam CMD_WR   = 3'd4;
+    localparam CMD_WAIT = 3'd7;
+    localparam WAIT_CNT_WIDTH = 27; // [29:3] of a WAIT slot
+
+    //=========================================================================
+    // Write data pattern generator
+    //=========================================================================
+    wire [CMD_WIDTH-1:0]    gen_cmd_tdata;
+    wire                    gen_cmd_tvalid;
+    wire                    gen_cmd_tready;
+    wire [WDATA_WIDTH-1:0]  gen_pattern;
+    wire                    gen_pattern_valid;
+
+    wdata_pattern_gen #(
+        .CMD_WIDTH(CMD_WIDTH),
+        .WDATA_WIDTH(WDATA_WIDTH)
+    ) wdata_pattern_gen_inst (
+        .clk(clk),
+        .rst(rst),
+        .S_AXIS_TDATA(S_AXIS_CMD_TDATA),
+        .S_AXIS_TVALID(S_AXIS_CMD_TVALID),
+        .S_AXIS_TREADY(S_AXIS_CMD_TREADY),
+        .M_AXIS_TDATA(gen_cmd_tdata),
+        .M_AXIS_TVALID(gen_cmd_tvalid),
+        .M_AXIS_TREADY(gen_cmd_tready),
+        .M_AXIS_PATTERN(gen_pattern),
+        .M_AXIS_PATTERN_VALID(gen_pattern_valid)
+    );
 
     //=========================================================================
     // Internal registers
     //=========================================================================
     reg [CMD_WIDTH-1:0]     cmd_reg;
+    reg [WDATA_WIDTH-1:0]   pattern_reg;
+    reg                     pattern_valid_reg;
     reg [WDATA_WIDTH-1:0]   wdata_reg;
     reg                     cmd_valid_reg;
     reg                     wdata_valid_reg;
@@ -73,7 +119,47 @@ module scheduler #(
                         (cmd_reg[34:32] == CMD_WR) ||
                         (cmd_reg[66:64] == CMD_WR) ||
                         (cmd_reg[98:96] == CMD_WR);
+
+    // WR slot that needs host wdata (pattern ID [19:17] of 0), decoded per
+    // slot so a host WR packed with a pattern WR still takes its MM2S beat
+    function is_host_wr;
+        input [31:0] slot;
+        begin
+            is_host_wr = (slot[2:0] == CMD_WR) && (slot[19:17] == 3'd0);
+        end
+    endfunction
+
+    wire has_host_wr_cmd;
+    assign has_host_wr_cmd = is_host_wr(cmd_reg[31:0])  ||
+                             is_host_wr(cmd_reg[63:32]) ||
+                             is_host_wr(cmd_reg[95:64]) ||
+                             is_host_wr(cmd_reg[127:96]);
     
+    //=========================================================================
+    // WAIT command detection in registered DDR4 command
+    //=========================================================================
+    // WAIT count of a slot (zero if the slot is not a WAIT)
+    function [WAIT_CNT_WIDTH+1:0] wait_count;
+        input [31:0] slot;
+        begin
+            if (slot[2:0] == CMD_WAIT && !slot[30])
+                wait_count = {2'b0, slot[3 +: WAIT_CNT_WIDTH]};
+            else
+                wait_count = {(WAIT_CNT_WIDTH+2){1'b0}};
+        end
+    endfunction
+
+    wire [WAIT_CNT_WIDTH+1:0] wait_total;
+    assign wait_total = wait_count(cmd_reg[31:0])  +
+                        wait_count(cmd_reg[63:32]) +
+                        wait_count(cmd_reg[95:64]) +
+                        wait_count(cmd_reg[127:96]);
+
+    // Remaining idle cycles before the next command word can be output
+    reg [WAIT_CNT_WIDTH+1:0] wait_cnt;
+    wire waiting;
+    assign waiting = (wait_cnt != {(WAIT_CNT_WIDTH+2){1'b0}});
+
     //=========================================================================
     // Output control logic
     //=========================================================================
@@ -81,11 +167,12 @@ module scheduler #(
     
     // Output is valid when:
     // - DDR4 command is valid AND
-    // - Either no WR command (don't need wdata) OR wdata is available
-    assign output_valid = cmd_valid_reg && (!has_wr_cmd || wdata_valid_reg);
+    // - No WAIT is in progress AND
+    // - Either no host WR command (don't need wdata) OR wdata is available
+    assign output_valid = cmd_valid_reg && !waiting && (!has_host_wr_cmd || wdata_valid_reg);
     
-    // wdata is consumed when output handshake occurs AND DDR4 command has WR command
-    assign wdata_consumed = output_valid && has_wr_cmd;
+    // wdata is consumed when output handshake occurs AND DDR4 command has host WR command
+    assign wdata_consumed = output_valid && has_host_wr_cmd;
     
     //=========================================================================
     // Ready signals - Independent acceptance
@@ -94,7 +181,7 @@ module scheduler #(
     // Accept new DDR4 command when:
     // - No DDR4 command stored, OR
     // - Output occurs in this cycle (current DDR4 command being sent out)
-    assign S_AXIS_CMD_TREADY = !cmd_valid_reg || output_valid;
+    assign gen_cmd_tready = !cmd_valid_reg || output_valid;
     
     // Accept new wdata when:
     // - No wdata stored, OR
@@ -105,8 +192,10 @@ module scheduler #(
     // Output signals
     //=========================================================================
     // Output DDR4 command and write data
-    // If no WR command, write data portion is zero
-    assign output_data = {(has_wr_cmd ? wdata_reg : {WDATA_WIDTH{1'b0}}), cmd_reg};
+    // If no WR command, write data portion is zero. A word carries one data
+    // beat; host data wins (cmd_buf_push keeps host and pattern WRs apart).
+    assign output_data = {(has_host_wr_cmd   ? wdata_reg   :
+                           pattern_valid_reg ? pattern_reg : {WDATA_WIDTH{1'b0}}), cmd_reg};
     
     //=========================================================================
     // Register capture logic
@@ -116,15 +205,20 @@ module scheduler #(
         if (rst) begin
             cmd_reg <= {CMD_WIDTH{1'b0}};
             wdata_reg <= {WDATA_WIDTH{1'b0}};
+            pattern_reg <= {WDATA_WIDTH{1'b0}};
+            pattern_valid_reg <= 1'b0;
             cmd_valid_reg <= 1'b0;
             wdata_valid_reg <= 1'b0;
+            wait_cnt <= {(WAIT_CNT_WIDTH+2){1'b0}};
         end else begin
             //=================================================================
             // DDR4 command register management
             //=================================================================
-            if (S_AXIS_CMD_TVALID && S_AXIS_CMD_TREADY) begin
-                // Capture new DDR4 command
-                cmd_reg <= S_AXIS_CMD_TDATA;
+            if (gen_cmd_tvalid && gen_cmd_tready) begin
+                // Capture new DDR4 command (and its pattern wdata)
+                cmd_reg <= gen_cmd_tdata;
+                pattern_reg <= gen_pattern;
+                pattern_valid_reg <= gen_pattern_valid;
                 cmd_valid_reg <= 1'b1;
             end else if (output_valid) begin
                 // DDR4 command sent out, clear valid
@@ -142,6 +236,16 @@ module scheduler #(
                 // Write data consumed by WR command, clear valid
                 wdata_valid_reg <= 1'b0;
             end
+
+            //=================================================================
+            // WAIT counter management
+            //=================================================================
+            if (output_valid) begin
+                // Start idle cycles after the WAIT slot has been output
+                wait_cnt <= wait_total;
+            end else if (waiting) begin
+                wait_cnt <= wait_cnt - 1'b1;
+            end
         end
     end
 
@@ -161,33 +265,23 @@ module scheduler #(
         end
     end
 
-    `ifdef SIMULATION
-    reg [31:0] cmd_count;
-    reg [31:0] wdata_count;
-    reg [31:0] output_count;
-    reg [31:0] wr_cmd_count;
-    reg [31:0] wait_cycles;  // Cycles waiting for wdata
-    
-    always @(posedge clk) begin
-        if (rst) begin
-            cmd_count <= 0;
-            wdata_count <= 0;
-            output_count <= 0;
-            wr_cmd_count <= 0;
-            wait_cycles <= 0;
-        end else begin
-            if (S_AXIS_CMD_TVALID && S_AXIS_CMD_TREADY)
-                cmd_count <= cmd_count + 1;
-            if (S_AXIS_WDATA_TVALID && S_AXIS_WDATA_TREADY)
-                wdata_count <= wdata_count + 1;
-            if (output_valid)
-                output_count <= output_count + 1;
-            if (output_valid && has_wr_cmd)
-                wr_cmd_count <= wr_cmd_count + 1;
-            if (cmd_valid_reg && has_wr_cmd && !wdata_valid_reg)
-                wait_cycles <= wait_cycles + 1;
-        end
-    end
-    `endif
+    //=========================================================================
+    // Performance events
+    //=========================================================================
+    // [0] command word accepted     [1] write data accepted
+    // [2] command word issued       [3] word with WR issued
+    // [4] waiting for host wdata    [5] idled by WAIT
+    // [6] bubble: no command word to issue (CMD FIFO empty)
+    assign perf_events = {
+        !cmd_valid_reg && !waiting,
+        waiting,
+        cmd_valid_reg && !waiting && has_host_wr_cmd && !wdata_valid_reg,
+        output_valid && has_wr_cmd,
+        output_valid,
+        S_AXIS_WDATA_TVALID && S_AXIS_WDATA_TREADY,
+        S_AXIS_CMD_TVALID && S_AXIS_CMD_TREADY
+    };
+
+    assign busy = gen_cmd_tvalid || cmd_valid_reg || waiting;
 
 endmodule
@@ -112,11 +112,18 @@ module sddt_core #(
   // =========================================================================
   // Internal Wires
   // =========================================================================
-  // Command FIFO <-> Scheduler
+  // Command FIFO <-> Loop Engine
+  wire         axis_cmd2engine_tready;
+  wire [127:0] axis_cmd2engine_tdata;
+  wire         axis_cmd2engine_tvalid;
+  wire         axis_cmd2engine_tlast;
+  // Loop Engine <-> Scheduler
   wire         axis_cmd2scheduler_tready;
   wire [127:0] axis_cmd2scheduler_tdata;
   wire         axis_cmd2scheduler_tvalid;
-  wire         axis_cmd2scheduler_tlast;
+  // Loop Engine status
+  wire         engine_running;
+  wire         engine_done_toggle;
   // Write Data FIFO <-> Scheduler
   wire         axis_wdata2scheduler_tready;
   wire [511:0] axis_wdata2scheduler_tdata;
@@ -135,6 +142,8 @@ module sddt_core #(
   wire [3:0]              ddr_ap;
   wire [3:0]              ddr_half_bl;
   wire [3:0]              ddr_pall;
+  wire [3:0]              ddr_rd_chain;
+  wire [3:0]              ddr_rank;
   wire [4*BG_WIDTH-1:0]   ddr_bg;
   wire [4*BANK_WIDTH-1:0] ddr_bank;
   wire [4*COL_WIDTH-1:0]  ddr_col;
@@ -144,6 +153,8 @@ module sddt_core #(
   wire [0:0]              rdDataEn;
   // Debug
   wire [31:0]  scheduler_debug_data;
+  wire [6:0]   scheduler_perf_events;
+  wire         scheduler_busy;
 
   // =========================================================================
   // Command FIFO (Async)
@@ -163,10 +174,10 @@ module sddt_core #(
   cmd_fifo (
     // Master interface
     .m_aclk(c0_ddr4_clk),
-    .m_axis_tready(axis_cmd2scheduler_tready),
-    .m_axis_tdata(axis_cmd2scheduler_tdata),
-    .m_axis_tvalid(axis_cmd2scheduler_tvalid),
-    .m_axis_tlast(axis_cmd2scheduler_tlast),
+    .m_axis_tready(axis_cmd2engine_tready),
+    .m_axis_tdata(axis_cmd2engine_tdata),
+    .m_axis_tvalid(axis_cmd2engine_tvalid),
+    .m_axis_tlast(axis_cmd2engine_tlast),
     // Slave interface
     .s_aclk(axi_aclk),
     .s_aresetn(axi_aresetn),
@@ -208,6 +219,30 @@ module sddt_core #(
     .wr_data_count_axis(wdata_fifo_wr_data_count)
   );
 
+  // =========================================================================
+  // Loop Engine (IMEM programs)
+  // =========================================================================
+  loop_engine #(
+    .CMD_WIDTH(CMD_FIFO_WIDTH), // 128
+    .INSTR_WIDTH(`INSTR_WIDTH),
+    .IMEM_ADDR_WIDTH(`IMEM_ADDR_WIDTH)
+  )
+  loop_engine_i (
+    .clk(c0_ddr4_clk),
+    .rst(c0_ddr4_rst || ~c0_init_calib_complete),
+    // Host command words
+    .S_AXIS_TDATA(axis_cmd2engine_tdata),
+    .S_AXIS_TVALID(axis_cmd2engine_tvalid),
+    .S_AXIS_TREADY(axis_cmd2engine_tready),
+    // Command words -> Scheduler
+    .M_AXIS_TDATA(axis_cmd2scheduler_tdata),
+    .M_AXIS_TVALID(axis_cmd2scheduler_tvalid),
+    .M_AXIS_TREADY(axis_cmd2scheduler_tready),
+    // Status
+    .running(engine_running),
+    .done_toggle(engine_done_toggle)
+  );
+
   // =========================================================================
   // Scheduler
   // =========================================================================
@@ -223,7 +258,7 @@ module sddt_core #(
     .S_AXIS_CMD_TDATA(axis_cmd2scheduler_tdata),
     .S_AXIS_CMD_TVALID(axis_cmd2scheduler_tvalid),
     .S_AXIS_CMD_TREADY(axis_cmd2scheduler_tready),
-    .S_AXIS_CMD_TLAST(axis_cmd2scheduler_tlast),
+    .S_AXIS_CMD_TLAST(1'b1), // Unused
     // Write data
     .S_AXIS_WDATA_TDATA(axis_wdata2scheduler_tdata),
     .S_AXIS_WDATA_TVALID(axis_wdata2scheduler_tvalid),
@@ -233,7 +268,10 @@ module sddt_core #(
     .output_valid(scheduler2decoder_valid),
     // Debug
     .debug_index(control_r[1:0]),
-    .debug_data(scheduler_debug_data)
+    .debug_data(scheduler_debug_data),
+    // Performance events
+    .perf_events(scheduler_perf_events),
+    .busy(scheduler_busy)
   );
 
   // =========================================================================
@@ -265,6 +303,8 @@ module sddt_core #(
     .ddr_ap(ddr_ap),
     .ddr_half_bl(ddr_half_bl),
     .ddr_pall(ddr_pall),
+    .ddr_rd_chain(ddr_rd_chain),
+    .ddr_rank(ddr_rank),
     .ddr_bg(ddr_bg),
     .ddr_bank(ddr_bank),
     .ddr_col(ddr_col),
@@ -331,6 +371,7 @@ module sddt_core #(
     .ddr_nop                (ddr_nop),
     .ddr_ap                 (ddr_ap),
     .ddr_pall               (ddr_pall),
+    .ddr_rank               (ddr_rank),
     .ddr_half_bl            (ddr_half_bl),
     .ddr_bg                 (ddr_bg),
     .ddr_bank               (ddr_bank),
@@ -358,23 +399,67 @@ module sddt_core #(
   localparam RDATA_FIFO_COUNT_WIDTH = $clog2(RDATA_FIFO_DEPTH)+1;
   wire [RDATA_FIFO_COUNT_WIDTH-1:0] rdata_fifo_wr_data_count;
 
-  // // -------------------------------------------------------------------------
-  // // TLAST Batching Logic
-  // // -------------------------------------------------------------------------
-  // reg [15:0] outstanding_reads;
-  // // Because there is a possibility that 4 read commands are issued in one cycle, we sum them up.
-  // wire [2:0] current_reads = ddr_read[0] + ddr_read[1] + ddr_read[2] + ddr_read[3];
-  // always @(posedge c0_ddr4_clk) begin
-  //   if (c0_ddr4_rst || ~c0_init_calib_complete) begin
-  //     outstanding_reads <= 16'd0;
-  //   end else begin
-  //     // Add the issued read count and subtract the returned data count.
-  //     outstanding_reads <= outstanding_reads + current_reads - rdDataEn[0];
-  //   end
-  // end
-  // // Set TLAST when the returned data is the last data in all the issued reads.
-  // wire rdata_s_axis_tlast = rdDataEn[0] && (outstanding_reads + current_reads == 16'd1);
-  // // -------------------------------------------------------------------------
+  // -------------------------------------------------------------------------
+  // TLAST Batching Logic
+  // -------------------------------------------------------------------------
+  // Read data returns in the order the RDs were issued, so the TLAST flag of
+  // each issued RD is queued here and popped when its data comes back.
+  // A RD with the chain flag set continues the batch (no TLAST); a plain RD
+  // ends it, so legacy single-beat reads still get TLAST on every beat.
+  localparam RD_TAG_DEPTH = 64; // > max reads in flight
+  localparam RD_TAG_PTR_WIDTH = $clog2(RD_TAG_DEPTH);
+  reg  [RD_TAG_DEPTH-1:0]     rd_tag_last;
+  reg  [RD_TAG_PTR_WIDTH-1:0] rd_tag_wr_ptr;
+  reg  [RD_TAG_PTR_WIDTH-1:0] rd_tag_rd_ptr;
+  // One tag per RD slot, in slot order: strict packets and compacted words
+  // can carry up to 4 RDs in one fabric cycle.
+  reg  [RD_TAG_PTR_WIDTH-1:0] rd_tag_wr_next;
+  integer rd_s;
+  always @(posedge c0_ddr4_clk) begin
+    if (c0_ddr4_rst || ~c0_init_calib_complete) begin
+      rd_tag_last   <= {RD_TAG_DEPTH{1'b0}};
+      rd_tag_wr_ptr <= {RD_TAG_PTR_WIDTH{1'b0}};
+      rd_tag_rd_ptr <= {RD_TAG_PTR_WIDTH{1'b0}};
+    end else begin
+      rd_tag_wr_next = rd_tag_wr_ptr;
+      for (rd_s = 0; rd_s < 4; rd_s = rd_s + 1) begin
+        if (ddr_read[rd_s]) begin
+          rd_tag_last[rd_tag_wr_next] <= !ddr_rd_chain[rd_s];
+          rd_tag_wr_next = rd_tag_wr_next + 1'b1;
+        end
+      end
+      rd_tag_wr_ptr <= rd_tag_wr_next;
+      if (rdDataEn[0]) begin
+        rd_tag_rd_ptr <= rd_tag_rd_ptr + 1'b1;
+      end
+    end
+  end
+  // Set TLAST when the returned data belongs to the last RD of a batch.
+  wire rd_beat_last = rd_tag_last[rd_tag_rd_ptr];
+  // -------------------------------------------------------------------------
+
+  // -------------------------------------------------------------------------
+  // Read Data Comparator
+  // -------------------------------------------------------------------------
+  // Compare RDs (pattern ID in [19:17]) are checked against the in-fabric
+  // pattern and only mismatch records and a batch summary are forwarded.
+  wire [511:0] rdata_s_axis_tdata;
+  wire         rdata_s_axis_tvalid;
+  wire         rdata_s_axis_tready; // No backpressure, low = overflow
+  wire         rdata_s_axis_tlast;
+  rdata_comparator rdata_comparator_inst (
+    .clk(c0_ddr4_clk),
+    .rst(c0_ddr4_rst || ~c0_init_calib_complete),
+    .cmd_data(scheduler2decoder_data[127:0]),
+    .cmd_valid(scheduler2decoder_valid),
+    .rd_data(rdData),
+    .rd_data_en(rdDataEn[0]),
+    .rd_data_last(rd_beat_last),
+    .m_tdata(rdata_s_axis_tdata),
+    .m_tlast(rdata_s_axis_tlast),
+    .m_tvalid(rdata_s_axis_tvalid)
+  );
+  // -------------------------------------------------------------------------
 
   xpm_fifo_axis #(
     .CLOCKING_MODE("independent_clock"),
@@ -394,18 +479,89 @@ module sddt_core #(
     // Slave interface
     .s_aclk(c0_ddr4_clk),
     .s_aresetn(~c0_ddr4_rst & c0_init_calib_complete),
-    .s_axis_tready(),
-    .s_axis_tdata(rdData),
-    .s_axis_tlast(1'b1),
+    .s_axis_tready(rdata_s_axis_tready),
+    .s_axis_tdata(rdata_s_axis_tdata),
+    .s_axis_tlast(rdata_s_axis_tlast),
     .s_axis_tkeep({64{1'b1}}),
-    .s_axis_tvalid(rdDataEn[0]),
+    .s_axis_tvalid(rdata_s_axis_tvalid),
     // Status signals
     .wr_data_count_axis(rdata_fifo_wr_data_count)
   );
 
-  // State output
-  assign state_i = control_r[31] ? scheduler_debug_data : {
-    8'b0,
+  // =========================================================================
+  // Performance Counters
+  // =========================================================================
+  // control_r[30] selects the counter window, [29] snapshot, [28] clear,
+  // [7:2] index (counter * 2 + high half). Counters:
+  //   0 cycles            1 command words      2 wdata beats
+  //   3 issued words      4 WR words           5 wdata stall cycles
+  //   6 WAIT idle cycles  7 CMD empty bubbles  8 RDATA overflows
+  //   9 ACT  10 PRE  11 RD  12 WR  13 REF  14 ZQ  15 read beats
+  localparam PERF_COUNTERS = 16;
+  // Issue window: counters 16/17 = first/last non-NOP issue (DRAM cycle).
+  // CFG register 8 in the stream marks a new window; the mark is delayed by
+  // the decoder stage so that it lines up with the ddr_* outputs.
+  localparam CFG_ISSUE_MARK = 4'd8;
+  reg perf_mark;
+  integer perf_slot;
+  reg perf_mark_scan;
+  always @(*) begin
+    perf_mark_scan = 1'b0;
+    for (perf_slot = 0; perf_slot < 4; perf_slot = perf_slot + 1)
+      if (scheduler2decoder_data[perf_slot*32 +: 3] == 3'd7 &&
+          scheduler2decoder_data[perf_slot*32 + 30] &&
+          scheduler2decoder_data[perf_slot*32 + 26 +: 4] == CFG_ISSUE_MARK)
+        perf_mark_scan = 1'b1;
+  end
+  always @(posedge c0_ddr4_clk) begin
+    if (c0_ddr4_rst || ~c0_init_calib_complete)
+      perf_mark <= 1'b0;
+    else
+      perf_mark <= scheduler2decoder_valid && perf_mark_scan;
+  end
+  function [2:0] popcount4;
+    input [3:0] v;
+    popcount4 = v[0] + v[1] + v[2] + v[3];
+  endfunction
+  wire [31:0] perf_data;
+  perf_counters #(
+    .N_COUNTERS(PERF_COUNTERS)
+  )
+  perf_counters_i (
+    .clk(c0_ddr4_clk),
+    .rst(c0_ddr4_rst || ~c0_init_calib_complete),
+    .inc({
+      {2'b0, rdDataEn[0]},
+      popcount4(ddr_zq),
+      popcount4(ddr_ref),
+      popcount4(ddr_write),
+      popcount4(ddr_read),
+      popcount4(ddr_pre),
+      popcount4(ddr_act),
+      {2'b0, rdata_s_axis_tvalid && !rdata_s_axis_tready},
+      {2'b0, scheduler_perf_events[6]},
+      {2'b0, scheduler_perf_events[5]},
+      {2'b0, scheduler_perf_events[4]},
+      {2'b0, scheduler_perf_events[3]},
+      {2'b0, scheduler_perf_events[2]},
+      {2'b0, scheduler_perf_events[1]},
+      {2'b0, scheduler_perf_events[0]},
+      3'd1
+    }),
+    .issue(ddr_act | ddr_pre | ddr_read | ddr_write | ddr_ref | ddr_zq),
+    .mark(perf_mark),
+    .snapshot(control_r[29]),
+    .clear(control_r[28]),
+    .index(control_r[7:2]),
+    .data(perf_data)
+  );
+
+  // State output ([31] program running, [30] program done toggle,
+  // [29] command words held past the CMD FIFO)
+  wire pipe_busy = axis_cmd2scheduler_tvalid || scheduler_busy;
+  assign state_i = control_r[31] ? scheduler_debug_data :
+                   control_r[30] ? perf_data : {
+    engine_running, engine_done_toggle, pipe_busy, 5'b0,
     { {(8-CMD_FIFO_COUNT_WIDTH){1'b0}}, cmd_fifo_wr_data_count },
     { {(8-WDATA_FIFO_COUNT_WIDTH){1'b0}}, wdata_fifo_wr_data_count },
     { {(8-RDATA_FIFO_COUNT_WIDTH){1'b0}}, rdata_fifo_wr_data_count }
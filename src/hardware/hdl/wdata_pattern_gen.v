@@ -0,0 +1,130 @@
+`timescale 1ns/1ps
+
+//=============================================================================
+// Write Data Pattern Generator
+//
+// Sits on the command stream in front of the scheduler and produces the
+// 512-bit write data of pattern WR commands in fabric, so these WRs need no
+// data from the host.
+//
+// Behavior:
+//   - Every 128-bit command word passes through the 6-cycle pattern_pipe
+//     (stalls as a whole on output backpressure)
+//   - pattern_tracker follows ACTs (open row per rank and bank) and CFGs (seed)
+//   - The first WR slot of a word with a non-zero pattern ID gets its write
+//     data generated and output together with the command word
+//
+// WR pattern fields:
+//   [19:17] - Pattern ID (0 = host data from the WDATA stream)
+//
+// Pattern IDs (word j = bits [32*j+31:32*j], i = column / 8):
+//   1 - FNV-1a hash of (rank, bank, row, seed, i, j), gen_data_pattern()
+//   2 - Solid:        seed
+//   3 - Checkerboard: (row ^ i ^ j) & 1 ? ~seed : seed
+//   4 - Row stripe:   row & 1 ? ~seed : seed
+//
+// CFG command (WAIT opcode with [30] set, a NOP for the DRAM):
+//   [29:26] - Register address
+//   [25:10] - 16-bit value
+//   Registers: 0 = seed[15:0], 1 = seed[31:16]
+//=============================================================================
+
+module wdata_pattern_gen #(
+    parameter CMD_WIDTH   = 128,
+    parameter WDATA_WIDTH = 512,
+    parameter BANK_ADDR_WIDTH = 4,
+    parameter ROW_WIDTH   = 17
+)(
+    input  wire                     clk,
+    input  wire                     rst,
+
+    // AXI Stream Slave - DDR4 command input
+    input  wire [CMD_WIDTH-1:0]     S_AXIS_TDATA,
+    input  wire                     S_AXIS_TVALID,
+    output wire                     S_AXIS_TREADY,
+
+    // AXI Stream Master - DDR4 command output with pattern write data
+    output wire [CMD_WIDTH-1:0]     M_AXIS_TDATA,
+    output wire                     M_AXIS_TVALID,
+    input  wire                     M_AXIS_TREADY,
+    output wire [WDATA_WIDTH-1:0]   M_AXIS_PATTERN,       // Generated write data
+    output wire                     M_AXIS_PATTERN_VALID  // Word has a pattern WR
+);
+
+    localparam CMD_WR   = 3'd4;
+    localparam PAT_HOST = 3'd0;
+
+    //=========================================================================
+    // Pipeline control
+    //=========================================================================
+    // All stages advance together when the last stage is free or drained
+    wire out_valid;
+    wire advance;
+    assign advance = !out_valid || M_AXIS_TREADY;
+    assign S_AXIS_TREADY = advance;
+
+    //=========================================================================
+    // Slot scan (row tracking, seed update, WR selection)
+    //=========================================================================
+    wire                       wr_found;
+    wire [2:0]                 wr_pat_id;
+    wire                       wr_rank;
+    wire [BANK_ADDR_WIDTH-1:0] wr_bank;
+    wire [ROW_WIDTH-1:0]       wr_row;
+    wire [9:0]                 wr_col;
+    wire [31:0]                wr_seed;
+
+    pattern_tracker #(
+        .CMD_WIDTH(CMD_WIDTH),
+        .TRACK_CMD(CMD_WR),
+        .BANK_ADDR_WIDTH(BANK_ADDR_WIDTH),
+        .ROW_WIDTH(ROW_WIDTH)
+    ) pattern_tracker_inst (
+        .clk(clk),
+        .rst(rst),
+        .cmd(S_AXIS_TDATA),
+        .update(S_AXIS_TVALID && S_AXIS_TREADY),
+        .found(wr_found),
+        .pat_id(wr_pat_id),
+        .rank(wr_rank),
+        .bank(wr_bank),
+        .row(wr_row),
+        .col(wr_col),
+        .seed(wr_seed)
+    );
+
+    //=========================================================================
+    // Pattern pipeline (command word and pattern flag as payload)
+    //=========================================================================
+    wire [CMD_WIDTH:0] out_payload;
+
+    pattern_pipe #(
+        .WDATA_WIDTH(WDATA_WIDTH),
+        .PAYLOAD_WIDTH(CMD_WIDTH + 1),
+        .BANK_ADDR_WIDTH(BANK_ADDR_WIDTH),
+        .ROW_WIDTH(ROW_WIDTH)
+    ) pattern_pipe_inst (
+        .clk(clk),
+        .rst(rst),
+        .ce(advance),
+        .in_valid(S_AXIS_TVALID),
+        .in_payload({wr_found && (wr_pat_id != PAT_HOST), S_AXIS_TDATA}),
+        .pat_id(wr_pat_id),
+        .rank(wr_rank),
+        .bank(wr_bank),
+        .row(wr_row),
+        .col(wr_col),
+        .seed(wr_seed),
+        .out_valid(out_valid),
+        .out_payload(out_payload),
+        .pattern(M_AXIS_PATTERN)
+    );
+
+    //=========================================================================
+    // Output
+    //=========================================================================
+    assign M_AXIS_TDATA         = out_payload[CMD_WIDTH-1:0];
+    assign M_AXIS_TVALID        = out_valid;
+    assign M_AXIS_PATTERN_VALID = out_payload[CMD_WIDTH];
+
+endmodule
@@ -0,0 +1,291 @@
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/version.h>
+#include <linux/fs.h>
+#include <linux/io.h>
+#include <linux/of.h>
+#include <linux/irq.h>
+#include <linux/irqdomain.h>
+#include <linux/interrupt.h>
+#include <linux/wait.h>
+#include <linux/poll.h>
+#include <linux/slab.h>
+#include <linux/list.h>
+#include <linux/spinlock.h>
+#include <linux/uaccess.h>
+#include <linux/eventfd.h>
+
+#define DRIVER_NAME  "dma_irq"
+#define DMA_PHY_ADDR 0xA0000000  // Address of AXI DMA in the hardware
+#define DMA_SIZE     0x00010000  // Size of AXI DMA register space (64KB)
+#define MM2S_DMASR   0x04        // MM2S Status
+#define S2MM_DMASR   0x34        // S2MM Status
+#define DMASR_IRQ    0x7000      // IOC_Irq | Dly_Irq | Err_Irq (write 1 to clear)
+#define GIC_SPI      0           // dt-bindings/interrupt-controller/arm-gic.h
+
+// ioctl: signal an eventfd on every DMA interrupt (fd < 0 to remove)
+#define DMA_IRQ_SET_EVENTFD _IOW('d', 0, int)
+
+// pl_ps_irq0[0] = MM2S, pl_ps_irq0[1] = S2MM
+static int spi_mm2s = 89;
+module_param(spi_mm2s, int, 0444);
+MODULE_PARM_DESC(spi_mm2s, "GIC SPI number of the MM2S interrupt");
+static int spi_s2mm = 90;
+module_param(spi_s2mm, int, 0444);
+MODULE_PARM_DESC(spi_s2mm, "GIC SPI number of the S2MM interrupt");
+
+// Event counters returned by read()
+struct dma_irq_events {
+    u32 mm2s_count;  // MM2S interrupts since load
+    u32 s2mm_count;  // S2MM interrupts since load
+    u32 mm2s_status; // MM2S DMASR at the last interrupt
+    u32 s2mm_status; // S2MM DMASR at the last interrupt
+};
+
+// Per open file state
+struct dma_irq_file {
+    struct list_head node;
+    struct dma_irq_events seen;  // Counters at the last read()
+    struct eventfd_ctx *efd;     // Optional eventfd
+};
+
+static int major_num; // Major number of the driver
+static void __iomem *dma_base;
+static unsigned int virq_mm2s;
+static unsigned int virq_s2mm;
+static struct dma_irq_events events;
+static LIST_HEAD(files);
+static DEFINE_SPINLOCK(events_lock);
+static DECLARE_WAIT_QUEUE_HEAD(events_wq);
+
+// New events since the last read()
+static bool has_events(struct dma_irq_file *f) {
+    unsigned long flags;
+    bool ret;
+    spin_lock_irqsave(&events_lock, flags);
+    ret = f->seen.mm2s_count != events.mm2s_count || f->seen.s2mm_count != events.s2mm_count;
+    spin_unlock_irqrestore(&events_lock, flags);
+    return ret;
+}
+
+// Interrupt handler: acknowledge in DMASR, count and wake up waiters
+static irqreturn_t dma_irq_handler(int irq, void *dev_id) {
+    bool mm2s = (irq == virq_mm2s);
+    u32 offset = mm2s ? MM2S_DMASR : S2MM_DMASR;
+    u32 status = ioread32(dma_base + offset);
+    struct dma_irq_file *f;
+
+    if (!(status & DMASR_IRQ)) {
+        return IRQ_NONE;
+    }
+    iowrite32(status & DMASR_IRQ, dma_base + offset);
+
+    spin_lock(&events_lock);
+    if (mm2s) {
+        events.mm2s_count++;
+        events.mm2s_status = status;
+    } else {
+        events.s2mm_count++;
+        events.s2mm_status = status;
+    }
+    list_for_each_entry(f, &files, node) {
+        if (f->efd) {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0)
+            eventfd_signal(f->efd);
+#else
+            eventfd_signal(f->efd, 1);
+#endif
+        }
+    }
+    spin_unlock(&events_lock);
+
+    wake_up_interruptible(&events_wq);
+    return IRQ_HANDLED;
+}
+
+// Function called when open is called
+static int dma_irq_open(struct inode *inode, struct file *filp) {
+    struct dma_irq_file *f = kzalloc(sizeof(*f), GFP_KERNEL);
+    unsigned long flags;
+
+    if (!f) {
+        return -ENOMEM;
+    }
+    // Only interrupts after open are reported
+    spin_lock_irqsave(&events_lock, flags);
+    f->seen = events;
+    list_add(&f->node, &files);
+    spin_unlock_irqrestore(&events_lock, flags);
+    filp->private_data = f;
+    return 0;
+}
+
+// Function called when the file is closed
+static int dma_irq_release(struct inode *inode, struct file *filp) {
+    struct dma_irq_file *f = filp->private_data;
+    unsigned long flags;
+
+    spin_lock_irqsave(&events_lock, flags);
+    list_del(&f->node);
+    spin_unlock_irqrestore(&events_lock, flags);
+    if (f->efd) {
+        eventfd_ctx_put(f->efd);
+    }
+    kfree(f);
+    return 0;
+}
+
+// Function called when read is called
+// Blocks until an interrupt arrives that this file has not seen yet.
+static ssize_t dma_irq_read(struct file *filp, char __user *buf, size_t count, loff_t *ppos) {
+    struct dma_irq_file *f = filp->private_data;
+    struct dma_irq_events snapshot;
+    unsigned long flags;
+    int ret;
+
+    if (count < sizeof(snapshot)) {
+        return -EINVAL;
+    }
+    if (!has_events(f)) {
+        if (filp->f_flags & O_NONBLOCK) {
+            return -EAGAIN;
+        }
+        ret = wait_event_interruptible(events_wq, has_events(f));
+        if (ret) {
+            return ret;
+        }
+    }
+    spin_lock_irqsave(&events_lock, flags);
+    snapshot = events;
+    f->seen = events;
+    spin_unlock_irqrestore(&events_lock, flags);
+
+    if (copy_to_user(buf, &snapshot, sizeof(snapshot))) {
+        return -EFAULT;
+    }
+    return sizeof(snapshot);
+}
+
+// Function called when poll/select is called
+static __poll_t dma_irq_poll(struct file *filp, poll_table *wait) {
+    struct dma_irq_file *f = filp->private_data;
+
+    poll_wait(filp, &events_wq, wait);
+    return has_events(f) ? (EPOLLIN | EPOLLRDNORM) : 0;
+}
+
+// Function called when ioctl is called
+static long dma_irq_ioctl(struct file *filp, unsigned int cmd, unsigned long arg) {
+    struct dma_irq_file *f = filp->private_data;
+    struct eventfd_ctx *efd = NULL;
+    struct eventfd_ctx *old;
+    unsigned long flags;
+    int fd = (int)arg;
+
+    if (cmd != DMA_IRQ_SET_EVENTFD) {
+        return -ENOTTY;
+    }
+    if (fd >= 0) {
+        efd = eventfd_ctx_fdget(fd);
+        if (IS_ERR(efd)) {
+            return PTR_ERR(efd);
+        }
+    }
+    spin_lock_irqsave(&events_lock, flags);
+    old = f->efd;
+    f->efd = efd;
+    spin_unlock_irqrestore(&events_lock, flags);
+    if (old) {
+        eventfd_ctx_put(old);
+    }
+    return 0;
+}
+
+static const struct file_operations fops = {
+    .owner = THIS_MODULE,
+    .open = dma_irq_open,
+    .release = dma_irq_release,
+    .read = dma_irq_read,
+    .poll = dma_irq_poll,
+    .unlocked_ioctl = dma_irq_ioctl,
+};
+
+// Map a GIC SPI to a Linux interrupt number (level high)
+static unsigned int map_spi(struct device_node *gic, int spi) {
+    struct irq_fwspec fwspec = {
+        .fwnode = of_node_to_fwnode(gic),
+        .param_count = 3,
+        .param = { GIC_SPI, spi, IRQ_TYPE_LEVEL_HIGH },
+    };
+    return irq_create_fwspec_mapping(&fwspec);
+}
+
+static void release_resources(void) {
+    if (virq_s2mm) {
+        free_irq(virq_s2mm, &events);
+        irq_dispose_mapping(virq_s2mm);
+        virq_s2mm = 0;
+    }
+    if (virq_mm2s) {
+        free_irq(virq_mm2s, &events);
+        irq_dispose_mapping(virq_mm2s);
+        virq_mm2s = 0;
+    }
+    if (dma_base) {
+        iounmap(dma_base);
+        dma_base = NULL;
+    }
+}
+
+static int __init mod_init(void) {
+    struct device_node *gic;
+    unsigned int virq;
+    int ret;
+
+    dma_base = ioremap(DMA_PHY_ADDR, DMA_SIZE);
+    if (!dma_base) {
+        return -ENOMEM;
+    }
+    gic = of_find_compatible_node(NULL, NULL, "arm,gic-400");
+    if (!gic) {
+        printk(KERN_ERR "DMA IRQ driver: GIC not found\n");
+        release_resources();
+        return -ENODEV;
+    }
+    // MM2S interrupt
+    virq = map_spi(gic, spi_mm2s);
+    if (!virq || (ret = request_irq(virq, dma_irq_handler, 0, "dma_irq_mm2s", &events))) {
+        if (virq) irq_dispose_mapping(virq);
+        of_node_put(gic);
+        release_resources();
+        return virq ? ret : -EINVAL;
+    }
+    virq_mm2s = virq;
+    // S2MM interrupt
+    virq = map_spi(gic, spi_s2mm);
+    if (!virq || (ret = request_irq(virq, dma_irq_handler, 0, "dma_irq_s2mm", &events))) {
+        if (virq) irq_dispose_mapping(virq);
+        of_node_put(gic);
+        release_resources();
+        return virq ? ret : -EINVAL;
+    }
+    virq_s2mm = virq;
+    of_node_put(gic);
+
+    major_num = register_chrdev(0, DRIVER_NAME, &fops);
+    if (major_num < 0) {
+        release_resources();
+        return major_num;
+    }
+    printk(KERN_INFO "DMA IRQ driver loaded. Major: %d, IRQ MM2S: %u, IRQ S2MM: %u\n", major_num, virq_mm2s, virq_s2mm);
+    return 0;
+}
+
+static void __exit mod_exit(void) {
+    unregister_chrdev(major_num, DRIVER_NAME);
+    release_resources();
+}
+
+module_init(mod_init);
+module_exit(mod_exit);
+MODULE_LICENSE("GPL");
@@ -4,31 +4,26 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <poll.h>
 #include <unistd.h>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "api.h"
+#include "backend.h"
+#include "timing.h"
 
 // Utilities
 #define REG_WRITE(addr, val) (*(volatile uint32_t *)(addr) = (val))
 #define REG_READ(addr)       (*(volatile uint32_t *)(addr))
-
-// DMA Register Offsets
-#define MM2S_DMACR      0x00 // Control
-#define MM2S_DMASR      0x04 // Status
-#define MM2S_SA         0x18 // Source Address
-#define MM2S_SA_MSB     0x1C // 32bit addressing
-#define MM2S_LENGTH     0x28 // Length of the transfer
-#define S2MM_DMACR      0x30 // Control
-#define S2MM_DMASR      0x34 // Status
-#define S2MM_DA         0x48 // Destination Address
-#define S2MM_DA_MSB     0x4C // 32bit addressing
-#define S2MM_LENGTH     0x58 // Length of the transfer
-
-// GPIO Register Offsets
-#define GPIO_DATA       0x00  // Channel 1 Data Register
-#define GPIO_TRI        0x04  // Channel 1 Tri-state Register (0=output, 1=input)
-#define GPIO2_DATA      0x08  // Channel 2 Data Register
-#define GPIO2_TRI       0x0C  // Channel 2 Tri-state Register (0=output, 1=input)
+// Device registers (DMA, GPIO) go through the backend
+#define MMIO_WRITE(addr, val) backend->mmio_write((volatile void *)(addr), (val))
+#define MMIO_READ(addr)       backend->mmio_read((volatile void *)(addr))
 
 // Physical Addresses
 #define AXI_DMA_0_BASE  0xA0000000
@@ -38,14 +33,41 @@
 #define AXI_BRIDGE_BASE 0xB0000000
 #define AXI_BRIDGE_SIZE 0x00010000 // 64KB (NOTE: Mapped memory size, not FIFO size)
 
-// Timing Parameters
-// tCK = 1.5ns (666MHz)
-#define nRP    9  // tRP  = 14.16ns, nRP  = 14.16 / 1.5 = 9.44
-#define nRCD   9  // tRCD = 14.16ns, nRCD = 14.16 / 1.5 = 9.44
-#define nRAS   21 // tRAS = 32.00ns, nRAS = 32.00 / 1.5 = 21.33
-#define nCCD_L 3  // tCCD_L = 6 * 0.833 = 5.0ns, nCCD_L = 5.0 / 1.5 = 3.33
-// tREFI = 7.8us
-#define nRFC 233 // tRFC = 421 * 0.833 = 350.693ns, nRFC = 350.693 / 1.5 = 233.795
+// Command Buffer Parameters
+#define ROW_CMD_BUF_WORDS 1024 // PRE + ACT + 128 WR/RD, each followed by a WAIT (260 words)
+#define READ_GROUP_COLS   8    // RDs in flight per group (half of the 16-deep RDATA FIFO)
+#define ILV_MAX_BANKS     16   // Rows per interleaved operation
+#define ILV_CMD_BUF_WORDS (ILV_MAX_BANKS * (2 + 128) + 16)  // PRE + ACT + 128 WR/RD per row, seed CFG
+#define ILV_OUT_BUF_WORDS (4 * ILV_CMD_BUF_WORDS)           // Compacted (up to 4 slots per command)
+
+// DMA Interrupt Device (src/kernel_module/dma_irq.c)
+#define DMA_IRQ_DEV          "/dev/dma_irq"
+#define DMA_IRQ_SET_EVENTFD  _IOW('d', 0, int) // Must match dma_irq.c
+#define DMA_IRQ_TIMEOUT_MS   1000 // No interrupt for this long is a timeout
+#define DMA_POLL_ITERS       10000000 // Spin polling timeout
+#define PERF_READ_TRIES      16 // Reads of a shadow counter half until two agree
+#define DRAIN_TIMEOUT_MS     5000 // No drained GPIO state for this long is a timeout
+
+// CMD FIFO Credits
+// Command words can still be between the bridge and the CMD FIFO (bridge and
+// width converter registers, the partial word of the upsizer) after a flush.
+#define CMD_CREDIT_MARGIN    2
+
+#define WORD_NCK             4 // DRAM cycles per 128-bit command word (one fabric cycle)
+
+// Bridge Store Width
+#if defined(__ARM_NEON)
+#define BRIDGE_STORE_MAX     128
+#else
+#define BRIDGE_STORE_MAX     64
+#endif
+
+// DMA Queue Parameters
+// udmabuf layout: [MM2S row slots][S2MM row slots][MM2S ring][S2MM ring]
+// The synchronous helpers use the beginning of the udmabuf after draining.
+#define DMA_ROW_BYTES   (16 * 128 * sizeof(uint32_t)) // 8KB, one row
+#define DMA_MAX_SLOTS   16 // Row slots per direction
+#define DMA_RING_BYTES  (DMA_MAX_SLOTS * SG_DESC_SIZE)
 
 int mem_fd;
 int bridge_fd;
@@ -56,12 +78,57 @@ void *udmabuf_vptr;
 unsigned int udmabuf_size;
 unsigned long udmabuf_phys_addr;
 void *gpio_vptr;
-// // Bridge index tracking (for circular buffer)
-// static uint32_t bridge_32bit_index = 0;
-// static uint32_t bridge_64bit_index = 0;
+// Active DDR4 timing profile (timing.h)
+timing_profile_t timing;
+// Command buffer shared by the row helpers
+static cmd_buf_t row_cb;
+// Refresh scheduler (see refresh_config)
+static refresh_mode_t refresh_mode = REFRESH_MANUAL;
+static uint32_t refresh_postpone = 1;
+static uint8_t refresh_ranks = 1;
+static struct timespec refresh_t0;
+static uint64_t refresh_done[REFRESH_MAX_RANKS]; // tREFI intervals covered per rank
+static refresh_stats_t refresh_st;
+static uint32_t refresh_service(void);
+// Command buffers of the interleaved row helpers (recorded order, compacted)
+static cmd_buf_t ilv_cb;
+static cmd_buf_t ilv_out;
+// DMA transfer queue (one per channel)
+// In scatter-gather mode each slot owns one descriptor of a circular ring.
+// In simple mode only the newest transfer can be in flight.
+typedef struct {
+    bool mm2s;                    // MM2S (send) or S2MM (recv)
+    volatile uint8_t *desc;       // Descriptor ring (host address)
+    unsigned long desc_phys;      // Descriptor ring (physical address)
+    uint32_t n;                   // Number of slots
+    uint32_t head;                // Next slot to queue
+    uint32_t tail;                // Oldest queued slot
+    uint32_t count;               // Queued slots not yet reaped
+    bool busy;                    // Simple mode: newest transfer in flight
+} dma_queue_t;
+static bool dma_sg;
+static int dma_irq_fd = -1;
+static dma_wait_mode_t dma_wait_mode = DMA_WAIT_POLL;
+static uint32_t dma_spin_iters;
+static uint32_t dma_slots;
+static dma_queue_t mm2s_q;
+static dma_queue_t s2mm_q;
+// Bridge stores (see bridge_config)
+static uint32_t bridge_store_bits = 32;
+static bool bridge_set;
+static uint32_t bridge_off;        // Byte offset of the next store in the window (ring)
+static bool bridge_pending;        // Stores not yet known to have reached the bridge
+static uint8_t send_slots;         // Slots of the 128-bit word cmd_send is filling
+// GPIO control (channel 2) as last written, for the view of the state word
+static uint32_t gpio_ctrl;
 
-// Cleanup Memory Mappings
-static void cleanup_mem_mappings(void) {
+// Backend (see backend.h)
+static const backend_t *backend = &hw_backend;
+static bool backend_set;
+static void hw_bridge_flush(void);
+
+// Cleanup Memory Mappings (hardware backend)
+static void hw_cleanup(void) {
     if (udmabuf_vptr != NULL && udmabuf_vptr != MAP_FAILED) {
         munmap(udmabuf_vptr, udmabuf_size);
         udmabuf_vptr = NULL;
@@ -70,7 +137,12 @@ static void cleanup_mem_mappings(void) {
         close(udmabuf_fd);
         udmabuf_fd = -1;
     }
+    if (gpio_vptr != NULL && gpio_vptr != MAP_FAILED) {
+        munmap(gpio_vptr, AXI_GPIO_SIZE);
+        gpio_vptr = NULL;
+    }
     if (bridge_vptr != NULL) {
+        hw_bridge_flush();
         munmap(bridge_vptr, AXI_BRIDGE_SIZE);
         bridge_vptr = NULL;
     }
@@ -88,6 +160,25 @@ static void cleanup_mem_mappings(void) {
     }
 }
 
+// Cleanup Memory Mappings
+static void cleanup_mem_mappings(void) {
+    if (dma_irq_fd >= 0) {
+        dma_set_wait_mode(DMA_WAIT_POLL, 0);
+        close(dma_irq_fd);
+        dma_irq_fd = -1;
+    }
+    if (row_cb.words != NULL) {
+        cmd_buf_free(&row_cb);
+    }
+    if (ilv_cb.words != NULL) {
+        cmd_buf_free(&ilv_cb);
+    }
+    if (ilv_out.words != NULL) {
+        cmd_buf_free(&ilv_out);
+    }
+    backend->cleanup();
+}
+
 // Read and Parse Sysfs Attribute
 static int read_sysfs_attr(const char *path, const char *format, void *value) {
     int tmp_fd;
@@ -111,8 +202,208 @@ static int read_sysfs_attr(const char *path, const char *format, void *value) {
     return 0;
 }
 
-// Initialize Hardware
-int setup_hardware() {
+// DMA Queue Slot Offset (from the udmabuf base)
+static unsigned long dma_slot_offset(const dma_queue_t *q, uint32_t slot) {
+    return (q->mm2s ? 0 : dma_slots * DMA_ROW_BYTES) + slot * DMA_ROW_BYTES;
+}
+
+// DMA Queue Timeout
+static void dma_queue_timeout(const dma_queue_t *q) {
+    volatile uint8_t *base = (volatile uint8_t *)dma0_vptr;
+    uint32_t final_cr = MMIO_READ(base + (q->mm2s ? MM2S_DMACR : S2MM_DMACR));
+    uint32_t final_status = MMIO_READ(base + (q->mm2s ? MM2S_DMASR : S2MM_DMASR));
+    fprintf(stderr, "DMA %s queue timed out! DMACR: 0x%08X, DMASR: 0x%08X\n", q->mm2s ? "MM2S" : "S2MM", final_cr, final_status);
+    exit(1);
+}
+
+// DMA Channel Idle
+static bool dma_channel_idle(dma_queue_t *q) {
+    volatile uint8_t *base = (volatile uint8_t *)dma0_vptr;
+    return (MMIO_READ(base + (q->mm2s ? MM2S_DMASR : S2MM_DMASR)) & DMASR_IDLE) != 0;
+}
+
+// DMA IRQ Sleep (until the next DMA interrupt)
+// Interrupts that arrived since the last call wake up immediately, so a
+// condition checked right before sleeping cannot be missed.
+static bool dma_irq_sleep(void) {
+    struct pollfd pfd = { .fd = dma_irq_fd, .events = POLLIN };
+    uint32_t events[4];
+    int ret = poll(&pfd, 1, DMA_IRQ_TIMEOUT_MS);
+    if (ret == 0) return false;
+    if (ret < 0) {
+        if (errno == EINTR) return true; // Signal, check again
+        perror("Failed to poll " DMA_IRQ_DEV);
+        return false;
+    }
+    if (read(dma_irq_fd, events, sizeof(events)) < 0) {
+        perror("Failed to read " DMA_IRQ_DEV);
+        return false;
+    }
+    return true;
+}
+
+// DMA Wait
+// Polls cond in DMA_WAIT_POLL mode, sleeps on the DMA interrupt in
+// DMA_WAIT_IRQ mode and spins for dma_spin_iters before sleeping in
+// DMA_WAIT_HYBRID mode. Returns false on timeout.
+static bool dma_wait(dma_queue_t *q, bool (*cond)(dma_queue_t *q)) {
+    uint32_t spin = DMA_POLL_ITERS;
+    if (dma_wait_mode == DMA_WAIT_IRQ) spin = 0;
+    if (dma_wait_mode == DMA_WAIT_HYBRID) spin = dma_spin_iters;
+    for (uint32_t i = 0; i < spin; i++) {
+        if (cond(q)) return true;
+    }
+    if (dma_wait_mode == DMA_WAIT_POLL) return cond(q);
+    while (!cond(q)) {
+        if (!dma_irq_sleep()) return cond(q);
+    }
+    return true;
+}
+
+// DMA Queue Initialization
+static void dma_queue_init(dma_queue_t *q, bool mm2s, unsigned long ring_offset) {
+    memset(q, 0, sizeof(*q));
+    q->mm2s = mm2s;
+    q->n = dma_slots;
+    q->desc = (volatile uint8_t *)udmabuf_vptr + ring_offset;
+    q->desc_phys = udmabuf_phys_addr + ring_offset;
+    if (!dma_sg) return;
+    // Link descriptors into a circular ring
+    for (uint32_t i = 0; i < q->n; i++) {
+        volatile uint8_t *d = q->desc + i * SG_DESC_SIZE;
+        for (int j = 0; j < SG_DESC_SIZE; j += 4) {
+            REG_WRITE(d + j, 0);
+        }
+        REG_WRITE(d + SG_DESC_NXTDESC, q->desc_phys + ((i + 1) % q->n) * SG_DESC_SIZE);
+    }
+}
+
+// DMA Queue Setup
+// Scatter-gather mode is used when the DMA was built with the SG engine,
+// otherwise queued transfers fall back to simple register mode.
+static int dma_queue_setup(void) {
+    volatile uint8_t *base = (volatile uint8_t *)dma0_vptr;
+    if (udmabuf_size < 2 * DMA_ROW_BYTES + 2 * DMA_RING_BYTES) {
+        fprintf(stderr, "udmabuf too small for DMA queues: %u bytes\n", udmabuf_size);
+        return -1;
+    }
+    dma_slots = (udmabuf_size - 2 * DMA_RING_BYTES) / (2 * DMA_ROW_BYTES);
+    if (dma_slots > DMA_MAX_SLOTS) dma_slots = DMA_MAX_SLOTS;
+    dma_sg = (MMIO_READ(base + MM2S_DMASR) & DMASR_SG_INCLD) != 0;
+    if (dma_sg) {
+        // Halt both channels so CURDESC can be programmed on the first transfer
+        MMIO_WRITE(base + MM2S_DMACR, DMACR_RESET);
+        uint32_t timeout = 1000000;
+        while ((MMIO_READ(base + MM2S_DMACR) & DMACR_RESET) && --timeout);
+        if (timeout == 0) {
+            fprintf(stderr, "DMA reset timed out\n");
+            return -1;
+        }
+    }
+    unsigned long ring_offset = 2 * dma_slots * DMA_ROW_BYTES;
+    dma_queue_init(&mm2s_q, true, ring_offset);
+    dma_queue_init(&s2mm_q, false, ring_offset + DMA_RING_BYTES);
+    return 0;
+}
+
+// DMA Queue Done (oldest queued transfer completed)
+static bool dma_queue_done(dma_queue_t *q) {
+    volatile uint8_t *base = (volatile uint8_t *)dma0_vptr;
+    if (q->count == 0) return true;
+    if (dma_sg) {
+        uint32_t status = REG_READ(q->desc + q->tail * SG_DESC_SIZE + SG_DESC_STATUS);
+        if (status & SG_STS_ERR) {
+            fprintf(stderr, "DMA %s descriptor %u failed! Status: 0x%08X\n", q->mm2s ? "MM2S" : "S2MM", q->tail, status);
+            exit(1);
+        }
+        return (status & SG_STS_CMPLT) != 0;
+    }
+    // Simple mode: everything but the newest transfer has completed
+    if (q->count > 1) return true;
+    if (q->busy && (MMIO_READ(base + (q->mm2s ? MM2S_DMASR : S2MM_DMASR)) & DMASR_IDLE)) {
+        q->busy = false;
+    }
+    return !q->busy;
+}
+
+// DMA Queue Wait (oldest queued transfer)
+static void dma_queue_wait(dma_queue_t *q) {
+    if (!dma_wait(q, dma_queue_done)) dma_queue_timeout(q);
+}
+
+// DMA Queue Pop (release the oldest slot)
+static void dma_queue_pop(dma_queue_t *q) {
+    q->tail = (q->tail + 1) % q->n;
+    q->count--;
+}
+
+// DMA Queue Reap (release all completed slots)
+static uint32_t dma_queue_reap(dma_queue_t *q) {
+    uint32_t n_reaped = 0;
+    while (q->count > 0 && dma_queue_done(q)) {
+        dma_queue_pop(q);
+        n_reaped++;
+    }
+    return n_reaped;
+}
+
+// DMA Queue Drain (wait for and release all slots)
+static void dma_queue_drain(dma_queue_t *q) {
+    while (q->count > 0) {
+        dma_queue_wait(q);
+        dma_queue_pop(q);
+    }
+}
+
+// DMA Queue Push
+// In SG mode the descriptor at the head is filled and the tail pointer moved,
+// so the engine keeps running without being re-armed. The oldest slot is
+// released first when the queue is full.
+static void dma_queue_push(dma_queue_t *q, unsigned long phys_addr, uint32_t length_bytes) {
+    volatile uint8_t *base = (volatile uint8_t *)dma0_vptr;
+    uint32_t cr_offset = q->mm2s ? MM2S_DMACR : S2MM_DMACR;
+    if (q->count == q->n) {
+        dma_queue_wait(q);
+        dma_queue_pop(q);
+    }
+    if (dma_sg) {
+        volatile uint8_t *d = q->desc + q->head * SG_DESC_SIZE;
+        unsigned long d_phys = q->desc_phys + q->head * SG_DESC_SIZE;
+        REG_WRITE(d + SG_DESC_BUFFER_ADDR, phys_addr);
+        REG_WRITE(d + SG_DESC_BUFFER_ADDR_MSB, 0); // 32bit addressing
+        REG_WRITE(d + SG_DESC_STATUS, 0);
+        REG_WRITE(d + SG_DESC_CONTROL, length_bytes | (q->mm2s ? SG_CTRL_TXSOF | SG_CTRL_TXEOF : 0));
+        __sync_synchronize(); // Descriptor must be visible before the tail moves
+        uint32_t cr = MMIO_READ(base + cr_offset);
+        if (!(cr & DMACR_RS)) {
+            // CURDESC can only be written while the channel is halted
+            MMIO_WRITE(base + (q->mm2s ? MM2S_CURDESC : S2MM_CURDESC), d_phys);
+            MMIO_WRITE(base + (q->mm2s ? MM2S_CURDESC_MSB : S2MM_CURDESC_MSB), 0);
+            MMIO_WRITE(base + cr_offset, cr | DMACR_RS);
+        }
+        // Set tail descriptor (starts fetching)
+        MMIO_WRITE(base + (q->mm2s ? MM2S_TAILDESC_MSB : S2MM_TAILDESC_MSB), 0);
+        MMIO_WRITE(base + (q->mm2s ? MM2S_TAILDESC : S2MM_TAILDESC), d_phys);
+    } else {
+        // Simple mode: wait for the transfer in flight, then re-arm
+        if (q->busy && !dma_wait(q, dma_channel_idle)) {
+            dma_queue_timeout(q);
+        }
+        uint32_t cr = MMIO_READ(base + cr_offset);
+        if (!(cr & DMACR_RS)) {
+            MMIO_WRITE(base + cr_offset, cr | DMACR_RS);
+        }
+        MMIO_WRITE(base + (q->mm2s ? MM2S_SA : S2MM_DA), phys_addr);
+        MMIO_WRITE(base + (q->mm2s ? MM2S_SA_MSB : S2MM_DA_MSB), 0); // 32bit addressing
+        MMIO_WRITE(base + (q->mm2s ? MM2S_LENGTH : S2MM_LENGTH), length_bytes);
+        q->busy = true;
+    }
+    q->head = (q->head + 1) % q->n;
+    q->count++;
+}
+
+// Map Devices (hardware backend)
+static int hw_setup(void) {
     // Initialize file descriptors to invalid values
     mem_fd = -1;
     bridge_fd = -1;
@@ -126,53 +417,203 @@ int setup_hardware() {
         perror("Failed to open /dev/mem");
         return -1;
     }
+    // Bridge store width (SDDT_BRIDGE=<32|64|128>, see bridge_config)
+    const char *bridge_env = getenv("SDDT_BRIDGE");
+    if (!bridge_set && bridge_env != NULL && bridge_config(strtoul(bridge_env, NULL, 10)) != 0) {
+        hw_cleanup();
+        return -1;
+    }
     // Open /dev/bridge
     if ((bridge_fd = open("/dev/mem", O_RDWR | O_SYNC)) == -1) {
         perror("Failed to open /dev/mem");
-    // if ((bridge_fd = open("/dev/bridge_wc", O_RDWR | O_SYNC)) == -1) {
-    //     perror("Failed to open /dev/bridge_wc");
+        hw_cleanup();
         return -1;
     }
+    bridge_off = 0;
+    bridge_pending = false;
     // Map DMA 0
     dma0_vptr = mmap(NULL, AXI_DMA_0_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, AXI_DMA_0_BASE);
     if (dma0_vptr == MAP_FAILED) {
         perror("Failed to map DMA 0");
-        cleanup_mem_mappings();
+        hw_cleanup();
         return -1;
     }
     // Map Bridge
     bridge_vptr = mmap(NULL, AXI_BRIDGE_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED, bridge_fd, AXI_BRIDGE_BASE);
     if (bridge_vptr == MAP_FAILED) {
         perror("Failed to map Bridge");
-        cleanup_mem_mappings();
+        hw_cleanup();
         return -1;
     }
     // Map GPIO
     gpio_vptr = mmap(NULL, AXI_GPIO_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED, mem_fd, AXI_GPIO_BASE);
     if (gpio_vptr == MAP_FAILED) {
         perror("Failed to map GPIO");
-        cleanup_mem_mappings();
+        hw_cleanup();
         return -1;
     }
     // Read udmabuf size
     if (read_sysfs_attr("/sys/class/u-dma-buf/udmabuf0/size", "%d", &udmabuf_size) != 0) {
-        cleanup_mem_mappings();
+        hw_cleanup();
         return -1;
     }
     // Read udmabuf phys_addr
     if (read_sysfs_attr("/sys/class/u-dma-buf/udmabuf0/phys_addr", "%lx", &udmabuf_phys_addr) != 0) {
-        cleanup_mem_mappings();
+        hw_cleanup();
         return -1;
     }
     // Map udmabuf
     if ((udmabuf_fd = open("/dev/udmabuf0", O_RDWR | O_SYNC)) == -1) {
         perror("Failed to open /dev/udmabuf0");
-        cleanup_mem_mappings();
+        hw_cleanup();
         return -1;
     }
     udmabuf_vptr = mmap(NULL, udmabuf_size, PROT_READ | PROT_WRITE, MAP_SHARED, udmabuf_fd, 0);
     if (udmabuf_vptr == MAP_FAILED) {
         perror("Failed to map UDMA Buffer");
+        hw_cleanup();
+        return -1;
+    }
+    return 0;
+}
+
+// Bridge Flush (hardware backend)
+// Bridge stores complete before the GPIO/DMA accesses that follow.
+static void hw_bridge_flush(void) {
+    if (!bridge_pending) return;
+#if defined(__aarch64__)
+    __asm__ volatile("dsb st" ::: "memory");
+#else
+    __sync_synchronize();
+#endif
+    bridge_pending = false;
+}
+
+// MMIO Read (hardware backend)
+// Commands written to the bridge complete first, so a GPIO read or a DMA
+// kick sees every command submitted before it.
+static uint32_t hw_mmio_read(volatile void *addr) {
+    hw_bridge_flush();
+    return REG_READ(addr);
+}
+
+// MMIO Write (hardware backend)
+static void hw_mmio_write(volatile void *addr, uint32_t value) {
+    hw_bridge_flush();
+    REG_WRITE(addr, value);
+}
+
+// Bridge Write (hardware backend)
+// The bridge ignores the address and forwards the written lanes in order, so
+// a 128-bit store carries four command words (a 64-bit store two). Stores go
+// to increasing addresses around the whole window (a ring).
+// The mapping is uncached (Device memory), so every store is one AXI write
+// and they reach the bridge in program order.
+// Pending stores are flushed before the ring wraps onto their addresses.
+static void hw_bridge_write(const uint32_t *words, uint32_t n_words) {
+    volatile uint8_t *bridge_base = (volatile uint8_t *)bridge_vptr;
+    uint32_t bits = bridge_store_bits;
+    uint32_t i = 0;
+    while (i < n_words) {
+        if (bridge_off == AXI_BRIDGE_SIZE) {
+            hw_bridge_flush();
+            bridge_off = 0;
+        }
+        volatile uint8_t *addr = bridge_base + bridge_off;
+        uint32_t n = 1;
+#if defined(__ARM_NEON)
+        if (bits >= 128 && n_words - i >= 4 && bridge_off % 16 == 0) {
+            *(volatile uint32x4_t *)addr = vld1q_u32(words + i);
+            n = 4;
+        } else
+#endif
+        if (bits >= 64 && n_words - i >= 2 && bridge_off % 8 == 0) {
+            uint64_t pair;
+            memcpy(&pair, words + i, sizeof(pair)); // words[i] in the low lanes
+            *(volatile uint64_t *)addr = pair;
+            n = 2;
+        } else {
+            *(volatile uint32_t *)addr = words[i];
+        }
+        i += n;
+        bridge_off += n * sizeof(uint32_t);
+    }
+    bridge_pending = true;
+}
+
+const backend_t hw_backend = {
+    .name = "hw",
+    .setup = hw_setup,
+    .cleanup = hw_cleanup,
+    .mmio_read = hw_mmio_read,
+    .mmio_write = hw_mmio_write,
+    .bridge_write = hw_bridge_write,
+    .bridge_flush = hw_bridge_flush,
+};
+
+// Set Backend
+void set_backend(const backend_t *b) {
+    backend = b;
+    backend_set = true;
+}
+
+// Bridge Configuration
+// store_bits is 32 (default), 64 or 128 (NEON) bits per bridge store. Without
+// a call, SDDT_BRIDGE=<bits> in the environment selects it.
+int bridge_config(uint32_t store_bits) {
+    if (store_bits != 32 && store_bits != 64 && store_bits != 128) {
+        fprintf(stderr, "Invalid bridge store width: %u bits\n", store_bits);
+        return -1;
+    }
+    if (store_bits > BRIDGE_STORE_MAX) {
+        fprintf(stderr, "Bridge store width %u needs NEON (at most %u bits)\n", store_bits, BRIDGE_STORE_MAX);
+        return -1;
+    }
+    bridge_flush();
+    bridge_store_bits = store_bits;
+    bridge_set = true;
+    return 0;
+}
+
+// Bridge Flush (barrier)
+// Every command written to the bridge so far reaches the fabric before any
+// later store or register access. cmd_buf_flush and cmd_send end with one;
+// device register accesses flush implicitly.
+void bridge_flush() {
+    backend->bridge_flush();
+}
+
+// Initialize Hardware
+// Without set_backend, SDDT_BACKEND=model selects the DDR4 model.
+// SDDT_TIMING names a timing profile file (see timing_load).
+int setup_hardware() {
+    // Load timing profile (SDDT_TIMING=<file>, default profile if unset)
+    if (timing_load(getenv("SDDT_TIMING"), &timing) != 0) {
+        return -1;
+    }
+    const char *name = getenv("SDDT_BACKEND");
+    if (!backend_set && name != NULL) {
+        if (strcmp(name, model_backend.name) == 0) {
+            backend = &model_backend;
+        } else if (strcmp(name, hw_backend.name) != 0) {
+            fprintf(stderr, "Unknown backend: %s\n", name);
+            return -1;
+        }
+    }
+    if (backend->setup() != 0) {
+        return -1;
+    }
+    // Set up DMA queues
+    if (dma_queue_setup() != 0) {
+        cleanup_mem_mappings();
+        return -1;
+    }
+    // Open DMA interrupt device (optional, polling is used without it)
+    dma_irq_fd = open(DMA_IRQ_DEV, O_RDWR);
+    // Allocate command buffer for the row helpers
+    if (cmd_buf_init(&row_cb, ROW_CMD_BUF_WORDS) != 0 ||
+        cmd_buf_init(&ilv_cb, ILV_CMD_BUF_WORDS) != 0 ||
+        cmd_buf_init(&ilv_out, ILV_OUT_BUF_WORDS) != 0) {
         cleanup_mem_mappings();
         return -1;
     }
@@ -187,26 +628,34 @@ void cleanup_hardware() {
 // DMA Transfer Start (MM2S: Memory to Stream / Send)
 void dma_send_start(void *dma_base, unsigned long phys_addr, uint32_t length_bytes) {
     volatile uint8_t *base = (volatile uint8_t *)dma_base;
+    // Scatter-gather mode: single descriptor
+    if (dma_sg) {
+        dma_queue_push(&mm2s_q, phys_addr, length_bytes);
+        return;
+    }
     // Ensure Run/Stop bit is 1
-    uint32_t cr = REG_READ(base + MM2S_DMACR);
+    uint32_t cr = MMIO_READ(base + MM2S_DMACR);
     if (!(cr & 1)) {
-        REG_WRITE(base + MM2S_DMACR, cr | 1);
+        MMIO_WRITE(base + MM2S_DMACR, cr | 1);
     }
     // Set source address
-    REG_WRITE(base + MM2S_SA, phys_addr);
-    REG_WRITE(base + MM2S_SA_MSB, 0); // 32bit addressing
+    MMIO_WRITE(base + MM2S_SA, phys_addr);
+    MMIO_WRITE(base + MM2S_SA_MSB, 0); // 32bit addressing
     // Set length (starts transfer)
-    REG_WRITE(base + MM2S_LENGTH, length_bytes);
+    MMIO_WRITE(base + MM2S_LENGTH, length_bytes);
 }
 
 // DMA Transfer Wait (MM2S: Memory to Stream / Send)
 void dma_send_wait(void *dma_base) {
     volatile uint8_t *base = (volatile uint8_t *)dma_base;
-    uint32_t timeout = 10000000;
-    while (!(REG_READ(base + MM2S_DMASR) & 0x02) && --timeout);
-    if (timeout == 0) {
-        uint32_t final_status = REG_READ(base + MM2S_DMASR);
-        uint32_t final_cr = REG_READ(base + MM2S_DMACR);
+    // Scatter-gather mode: wait for all queued descriptors
+    if (dma_sg) {
+        dma_queue_drain(&mm2s_q);
+        return;
+    }
+    if (!dma_wait(&mm2s_q, dma_channel_idle)) {
+        uint32_t final_status = MMIO_READ(base + MM2S_DMASR);
+        uint32_t final_cr = MMIO_READ(base + MM2S_DMACR);
         printf("\nDMA S2MM Timed out!\n");
         printf("Final DMACR: 0x%08X\n", final_cr);
         printf("Final DMASR: 0x%08X\n", final_status);
@@ -233,26 +682,34 @@ void dma_send(void *dma_base, unsigned long phys_addr, uint32_t length_bytes) {
 // DMA Transfer Start (S2MM: Stream to Memory / Receive)
 void dma_recv_start(void *dma_base, unsigned long phys_addr, uint32_t length_bytes) {
     volatile uint8_t *base = (volatile uint8_t *)dma_base;
+    // Scatter-gather mode: single descriptor
+    if (dma_sg) {
+        dma_queue_push(&s2mm_q, phys_addr, length_bytes);
+        return;
+    }
     // Ensure Run/Stop bit is 1
-    uint32_t cr = REG_READ(base + S2MM_DMACR);
+    uint32_t cr = MMIO_READ(base + S2MM_DMACR);
     if (!(cr & 1)) {
-        REG_WRITE(base + S2MM_DMACR, cr | 1);
+        MMIO_WRITE(base + S2MM_DMACR, cr | 1);
     }
     // Set destination address
-    REG_WRITE(base + S2MM_DA, phys_addr);
-    REG_WRITE(base + S2MM_DA_MSB, 0); // 32bit addressing
+    MMIO_WRITE(base + S2MM_DA, phys_addr);
+    MMIO_WRITE(base + S2MM_DA_MSB, 0); // 32bit addressing
     // Set length (starts transfer)
-    REG_WRITE(base + S2MM_LENGTH, length_bytes);
+    MMIO_WRITE(base + S2MM_LENGTH, length_bytes);
 }
 
 // DMA Transfer Wait (S2MM: Stream to Memory / Receive)
 void dma_recv_wait(void *dma_base) {
     volatile uint8_t *base = (volatile uint8_t *)dma_base;
-    uint32_t timeout = 10000000;
-    while (!(REG_READ(base + S2MM_DMASR) & 0x02) && --timeout);
-    if (timeout == 0) {
-        uint32_t final_status = REG_READ(base + S2MM_DMASR);
-        uint32_t final_cr = REG_READ(base + S2MM_DMACR);
+    // Scatter-gather mode: wait for all queued descriptors
+    if (dma_sg) {
+        dma_queue_drain(&s2mm_q);
+        return;
+    }
+    if (!dma_wait(&s2mm_q, dma_channel_idle)) {
+        uint32_t final_status = MMIO_READ(base + S2MM_DMASR);
+        uint32_t final_cr = MMIO_READ(base + S2MM_DMACR);
         printf("\nDMA S2MM Timed out!\n");
         printf("Final DMACR: 0x%08X\n", final_cr);
         printf("Final DMASR: 0x%08X\n", final_status);
@@ -276,6 +733,106 @@ void dma_recv(void *dma_base, unsigned long phys_addr, uint32_t length_bytes) {
     dma_recv_wait(dma_base);
 }
 
+// DMA Queue Slots
+uint32_t dma_queue_slots() {
+    return dma_slots;
+}
+
+// DMA Send Slot (next free MM2S slot to fill)
+uint32_t *dma_send_slot() {
+    if (mm2s_q.count == mm2s_q.n) {
+        dma_queue_wait(&mm2s_q);
+        dma_queue_pop(&mm2s_q);
+    }
+    return (uint32_t *)((uint8_t *)udmabuf_vptr + dma_slot_offset(&mm2s_q, mm2s_q.head));
+}
+
+// DMA Send Queue (MM2S from the slot returned by dma_send_slot)
+void dma_send_queue(uint32_t length_bytes) {
+    dma_queue_push(&mm2s_q, udmabuf_phys_addr + dma_slot_offset(&mm2s_q, mm2s_q.head), length_bytes);
+}
+
+// DMA Send Reap
+uint32_t dma_send_reap() {
+    return dma_queue_reap(&mm2s_q);
+}
+
+// DMA Send Drain
+void dma_send_drain() {
+    dma_queue_drain(&mm2s_q);
+}
+
+// DMA Receive Queue (S2MM into the next free slot)
+void dma_recv_queue(uint32_t length_bytes) {
+    if (s2mm_q.count == s2mm_q.n) {
+        fprintf(stderr, "DMA S2MM queue full: %u slots\n", s2mm_q.n);
+        exit(1);
+    }
+    dma_queue_push(&s2mm_q, udmabuf_phys_addr + dma_slot_offset(&s2mm_q, s2mm_q.head), length_bytes);
+}
+
+// DMA Receive Complete (waits for the oldest S2MM slot)
+// The slot stays valid until dma_recv_release.
+uint32_t *dma_recv_complete() {
+    if (s2mm_q.count == 0) {
+        fprintf(stderr, "DMA S2MM queue empty\n");
+        exit(1);
+    }
+    dma_queue_wait(&s2mm_q);
+    return (uint32_t *)((uint8_t *)udmabuf_vptr + dma_slot_offset(&s2mm_q, s2mm_q.tail));
+}
+
+// DMA Receive Release (oldest S2MM slot)
+void dma_recv_release() {
+    dma_queue_pop(&s2mm_q);
+}
+
+// DMA Receive Pending
+uint32_t dma_recv_pending() {
+    return s2mm_q.count;
+}
+
+// DMA Receive Drain (discards received data)
+void dma_recv_drain() {
+    dma_queue_drain(&s2mm_q);
+}
+
+// DMA Wait Mode
+// DMA_WAIT_IRQ and DMA_WAIT_HYBRID need the dma_irq kernel module; the DMA
+// interrupts are enabled only while one of them is selected.
+int dma_set_wait_mode(dma_wait_mode_t mode, uint32_t spin_iters) {
+    volatile uint8_t *base = (volatile uint8_t *)dma0_vptr;
+    if (mode != DMA_WAIT_POLL && dma_irq_fd < 0) {
+        fprintf(stderr, "DMA interrupts unavailable (%s not open)\n", DMA_IRQ_DEV);
+        return -1;
+    }
+    uint32_t irq_en = DMACR_IOC_IRQ | DMACR_ERR_IRQ;
+    uint32_t mm2s_cr = MMIO_READ(base + MM2S_DMACR) & ~irq_en;
+    uint32_t s2mm_cr = MMIO_READ(base + S2MM_DMACR) & ~irq_en;
+    if (mode != DMA_WAIT_POLL) {
+        mm2s_cr |= irq_en;
+        s2mm_cr |= irq_en;
+    }
+    MMIO_WRITE(base + MM2S_DMACR, mm2s_cr);
+    MMIO_WRITE(base + S2MM_DMACR, s2mm_cr);
+    dma_wait_mode = mode;
+    dma_spin_iters = spin_iters;
+    return 0;
+}
+
+// DMA IRQ Eventfd (signalled on every DMA interrupt, efd < 0 to remove)
+int dma_irq_eventfd(int efd) {
+    if (dma_irq_fd < 0) {
+        fprintf(stderr, "DMA interrupts unavailable (%s not open)\n", DMA_IRQ_DEV);
+        return -1;
+    }
+    if (ioctl(dma_irq_fd, DMA_IRQ_SET_EVENTFD, efd) != 0) {
+        perror("Failed to set DMA eventfd");
+        return -1;
+    }
+    return 0;
+}
+
 // GPIO Read
 uint32_t gpio_read(int channel, bool change_mode) {
     uint32_t tri_offset, data_offset;
@@ -290,9 +847,9 @@ uint32_t gpio_read(int channel, bool change_mode) {
         exit(1);
     }
     if (change_mode) {
-        REG_WRITE((volatile uint8_t *)gpio_vptr + tri_offset, 0xFFFFFFFF);
+        MMIO_WRITE((volatile uint8_t *)gpio_vptr + tri_offset, 0xFFFFFFFF);
     }
-    return REG_READ((volatile uint8_t *)gpio_vptr + data_offset);
+    return MMIO_READ((volatile uint8_t *)gpio_vptr + data_offset);
 }
 
 // GPIO Write
@@ -304,135 +861,446 @@ void gpio_write(int channel, uint32_t data, bool change_mode) {
     } else if (channel == 2) {
         tri_offset = GPIO2_TRI;
         data_offset = GPIO2_DATA;
+        gpio_ctrl = data;
     } else {
         fprintf(stderr, "Invalid channel: %d\n", channel);
         exit(1);
     }
     if (change_mode) {
-        REG_WRITE((volatile uint8_t *)gpio_vptr + tri_offset, 0x00000000);
-    }
-    REG_WRITE((volatile uint8_t *)gpio_vptr + data_offset, data);
-}
-
-// // Command Send (64-bit)
-// void cmd_send_64bit(uint32_t data, uint32_t interval) {
-//     // Pack data(32bit) + interval*NOP(32bit) into 64bit words (2x32bit per 64bit)
-//     uint32_t num_64bit_words = (1 + interval + 1) / 2; // ceil((1+interval)/2)
-//     uint32_t packet_len_bytes = 8*num_64bit_words;
-//     if (packet_len_bytes > AXI_BRIDGE_SIZE) {
-//         fprintf(stderr, "Packet length is too long: %d bytes\n", packet_len_bytes);
-//         exit(1);
-//     }
-//     volatile uint64_t *bridge_base = (volatile uint64_t *)bridge_vptr;
-//     uint32_t max_index = AXI_BRIDGE_SIZE / 8; // Maximum index for 64-bit words
-//     // Write data (Full interface) -> burst transfer!
-//     // First 64bit: data(lower 32bit) + first NOP(upper 32bit)
-//     bridge_base[bridge_64bit_index] = ((uint64_t)0 << 32) | data;
-//     bridge_64bit_index++;
-//     if (bridge_64bit_index >= max_index) {
-//         bridge_64bit_index = 0;
-//     }
-//     // Remaining NOPs packed 2 per 64bit word (all NOPs are 0)
-//     // Loop unrolling and NEON can be used for further speedup
-//     for (int i = 1; i < num_64bit_words+1; i++) {
-//         bridge_base[bridge_64bit_index] = 0; // Two NOPs packed: 0(lower 32bit) + 0(upper 32bit)
-//         bridge_64bit_index++;
-//         if (bridge_64bit_index >= max_index) {
-//             bridge_64bit_index = 0;
-//         }
-//     }
-// }
-
-// Command Send (32-bit)
-void cmd_send_32bit(uint32_t cmd, uint32_t interval, bool strict) {
+        MMIO_WRITE((volatile uint8_t *)gpio_vptr + tri_offset, 0x00000000);
+    }
+    MMIO_WRITE((volatile uint8_t *)gpio_vptr + data_offset, data);
+}
+
+// GPIO State Wait
+// Polls the GPIO state until done() holds. A scheduler that stops issuing,
+// or read data with no S2MM transfer armed, is reported after
+// DRAIN_TIMEOUT_MS instead of hanging the host.
+static void state_wait(bool (*done)(uint32_t state), const char *what) {
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 1; ; i++) {
+        uint32_t state = gpio_read(1, false);
+        if (done(state)) return;
+        if (i % 1024 == 0) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            double ms = (now.tv_sec - start.tv_sec) * 1e3 + (now.tv_nsec - start.tv_nsec) * 1e-6;
+            if (ms > DRAIN_TIMEOUT_MS) {
+                fprintf(stderr, "%s timed out! State: 0x%08X (CMD %u, WDATA %u, RDATA %u)\n", what, state,
+                        STATE_CMD_FIFO(state), STATE_WDATA_FIFO(state), STATE_RDATA_FIFO(state));
+                exit(1);
+            }
+        }
+    }
+}
+
+// Bridge Write (32-bit words)
+static void bridge_write_words(const uint32_t *words, uint32_t n_words) {
+    backend->bridge_write(words, n_words);
+}
+
+// WAIT Command Encoding
+// 0b111 with a zero count is the legacy NOP; the scheduler expands the count
+// into idle cycles, so a WAIT(count) word spans 1 + count cycles.
+static uint32_t enc_wait(uint32_t count) {
+    return 0b111 | ((count & WAIT_MAX_COUNT) << 3); // WAIT
+}
+
+// Number of WAIT cycles carried by the next WAIT word of an interval
+static uint32_t wait_cycles(uint32_t interval) {
+    return interval > WAIT_MAX_COUNT + 1 ? WAIT_MAX_COUNT + 1 : interval;
+}
+
+// Number of 32-bit words needed for a command and its interval
+static uint32_t cmd_n_words(uint32_t interval, bool strict) {
     if (strict) {
-        cmd |= 1 << 31;
+        // Strict packets keep literal NOPs for slot-exact spacing
+        return 1 + interval;
+    }
+    return 1 + (interval + WAIT_MAX_COUNT) / (WAIT_MAX_COUNT + 1);
+}
+
+// Slot nCK
+// The fabric issues one 128-bit command word per fabric cycle (WORD_NCK):
+// a word packs slots up to the 4th or the first one without the strict
+// flag, and a WAIT holds the next word back by its count in fabric cycles.
+// The slot that opens a word carries the whole word, so sums over a stream
+// are exact (timing_check counts the same way). open_slots is the number of
+// slots already in the current word and is advanced past this one.
+static uint32_t slot_nck(uint32_t word, uint8_t *open_slots) {
+    uint32_t nck = *open_slots == 0 ? WORD_NCK : 0;
+    if ((word & 0b111) == 0b111 && !(word & (1u << 30))) {
+        nck += WORD_NCK * ((word >> 3) & WAIT_MAX_COUNT);
     }
-    uint32_t packet_len_bytes = 4*(1 + interval);
-    if (packet_len_bytes > AXI_BRIDGE_SIZE) {
-        fprintf(stderr, "Packet length is too long: %d bytes\n", packet_len_bytes);
+    *open_slots = (word >> 31) ? (*open_slots + 1) % 4 : 0;
+    return nck;
+}
+
+// Command Send (32-bit, returns nCK)
+uint32_t cmd_send_32bit(uint32_t cmd, uint32_t interval, bool strict) {
+    // Words are gathered so that the bridge can use its wide stores
+    uint32_t words[64];
+    uint32_t n_words = 0;
+    uint32_t nck = 0;
+
+    words[n_words++] = strict ? cmd | (1u << 31) : cmd;
+    while (interval > 0) {
+        if (n_words == sizeof(words) / sizeof(words[0])) {
+            for (uint32_t i = 0; i < n_words; i++) nck += slot_nck(words[i], &send_slots);
+            bridge_write_words(words, n_words);
+            n_words = 0;
+        }
+        if (strict) {
+            words[n_words++] = enc_wait(0) | (1u << 31); // NOP
+            interval--;
+        } else {
+            uint32_t cycles = wait_cycles(interval);
+            words[n_words++] = enc_wait(cycles - 1);
+            interval -= cycles;
+        }
+    }
+    for (uint32_t i = 0; i < n_words; i++) nck += slot_nck(words[i], &send_slots);
+    bridge_write_words(words, n_words);
+    return nck;
+}
+
+// Command Send (returns nCK)
+uint32_t cmd_send(uint32_t cmd, uint32_t interval, bool strict) {
+    uint32_t nck = cmd_send_32bit(cmd, interval, strict);
+    bridge_flush();
+    return nck;
+}
+
+// Rank Check
+// Ranks the PHY does not wire up (see MAX_RANKS) are rejected instead of
+// being sent to a CS_n that is tied off.
+static void rank_check(uint8_t rank_addr) {
+    if (rank_addr >= MAX_RANKS) {
+        fprintf(stderr, "Invalid rank %u: the PHY has %u rank(s)\n", rank_addr, MAX_RANKS);
         exit(1);
     }
-    volatile uint32_t *bridge_base = (volatile uint32_t *)bridge_vptr;
+}
+
+// Command Encoding
+static uint32_t enc_nop(void) {
+    return enc_wait(0); // NOP
+}
+
+static uint32_t enc_pre(uint8_t bank_addr, uint8_t rank_addr, bool bank_all) {
+    bank_addr &= 0xF; // 4 bits
+    rank_check(rank_addr);
+    rank_addr &= 0x1; // 1 bit
+    return 1 | (bank_addr << 3) | (bank_all << 7) | (rank_addr << 24); // Precharge
+}
+
+static uint32_t enc_act(uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr) {
+    bank_addr &= 0xF; // 4 bits
+    row_addr &= 0x1FFFF; // 17 bits
+    rank_check(rank_addr);
+    rank_addr &= 0x1; // 1 bit
+    return 2 | (bank_addr << 3) | (row_addr << 7) | (rank_addr << 24); // Activate
+}
 
-    bridge_base[0] = cmd;
-    for (int i = 0; i < interval; i++) {
-        bridge_base[0] = strict ? (0b111 | (1 << 31)) : 0b111;
+static uint32_t enc_rd(uint8_t bank_addr, uint16_t col_addr, uint8_t rank_addr, bool chain) {
+    bank_addr &= 0xF; // 4 bits
+    col_addr &= 0x3FF; // 10 bits
+    rank_check(rank_addr);
+    rank_addr &= 0x1; // 1 bit
+    return 3 | (bank_addr << 3) | (col_addr << 7) | (rank_addr << 24) | (chain << 30); // Read (chain: no TLAST on its data)
+}
+
+static uint32_t enc_rd_compare(uint8_t bank_addr, uint16_t col_addr, uint8_t rank_addr, bool chain, uint8_t pattern_id) {
+    pattern_id &= 0x7; // 3 bits
+    return enc_rd(bank_addr, col_addr, rank_addr, chain) | (pattern_id << 17); // Read (data compared in fabric)
+}
+
+static uint32_t enc_wr(uint8_t bank_addr, uint16_t col_addr, uint8_t rank_addr) {
+    bank_addr &= 0xF; // 4 bits
+    col_addr &= 0x3FF; // 10 bits
+    rank_check(rank_addr);
+    rank_addr &= 0x1; // 1 bit
+    return 4 | (bank_addr << 3) | (col_addr << 7) | (rank_addr << 24); // Write
+}
+
+static uint32_t enc_wr_pattern(uint8_t bank_addr, uint16_t col_addr, uint8_t rank_addr, uint8_t pattern_id) {
+    pattern_id &= 0x7; // 3 bits
+    return enc_wr(bank_addr, col_addr, rank_addr) | (pattern_id << 17); // Write (data generated in fabric)
+}
+
+static uint32_t enc_cfg(uint8_t reg_addr, uint16_t value) {
+    reg_addr &= 0xF; // 4 bits
+    return 7 | (reg_addr << 26) | ((uint32_t)value << 10) | (1u << 30); // Configuration (WAIT with CFG flag)
+}
+
+static uint32_t enc_rf(uint8_t rank_addr) {
+    rank_check(rank_addr);
+    rank_addr &= 0x1; // 1 bit
+    return 5 | (rank_addr << 24); // Refresh
+}
+
+// Command Buffer Initialize
+int cmd_buf_init(cmd_buf_t *cb, uint32_t capacity) {
+    cb->words = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+    if (cb->words == NULL) {
+        perror("Failed to allocate command buffer");
+        return -1;
     }
+    cb->n_words = 0;
+    cb->capacity = capacity;
+    cb->nck = 0;
+    cb->n_sent = 0;
+    cb->open_slots = 0;
+    cb->open_wr = 0;
+    return 0;
+}
+
+// Command Buffer Free
+void cmd_buf_free(cmd_buf_t *cb) {
+    free(cb->words);
+    cb->words = NULL;
+    cb->n_words = 0;
+    cb->capacity = 0;
+    cb->nck = 0;
+    cb->n_sent = 0;
+    cb->open_slots = 0;
+    cb->open_wr = 0;
+}
+
+// Command Buffer Reset (drop recorded commands without sending them)
+void cmd_buf_reset(cmd_buf_t *cb) {
+    cb->n_words = 0;
+    cb->nck = 0;
+    cb->n_sent = 0;
+    cb->open_slots = 0;
+    cb->open_wr = 0;
+}
+
+// Command Buffer Flush (submit all recorded words to the bridge)
+// Words already accepted by cmd_buf_submit are not sent again. The store
+// blocks while the CMD FIFO is full.
+uint32_t cmd_buf_flush(cmd_buf_t *cb) {
+    uint32_t nck = cb->nck;
+    bridge_write_words(cb->words + cb->n_sent, cb->n_words - cb->n_sent);
+    bridge_flush();
+    cmd_buf_reset(cb);
+    return nck;
+}
 
-    // // Index increment
-    // uint32_t max_index = AXI_BRIDGE_SIZE / 4; // Maximum index for 32-bit words
-    // // Write data (Full interface) -> burst transfer!
-    // // Command
-    // bridge_base[bridge_32bit_index] = cmd;
-    // bridge_32bit_index++;
-    // if (bridge_32bit_index >= max_index) {
-    //     bridge_32bit_index = 0;
-    // }
-    // // Interval (NOP)
-    // // Loop unrolling and NEON can be used for further speedup
-    // for (int i = 1; i < interval+1; i++) {
-    //     uint32_t nop_cmd = strict ? (0b111 | (1 << 31)) : 0b111;
-    //     bridge_base[bridge_32bit_index] = nop_cmd;
-    //     bridge_32bit_index++;
-    //     if (bridge_32bit_index >= max_index) {
-    //         bridge_32bit_index = 0;
-    //     }
-    // }
+// Command Buffer Submit (non-blocking)
+// Sends only as many recorded words as the CMD FIFO has credits for, so the
+// stores never stall on a full FIFO. Returns the number of words accepted;
+// the rest stays recorded for the next submit (or cmd_buf_flush).
+// Only whole strict packets are sent: the scheduler would otherwise issue
+// the first part and wait for the rest with the timing already broken. A
+// packet larger than the free FIFO goes out once the FIFO is empty, and its
+// stores may then block until the scheduler takes the excess.
+uint32_t cmd_buf_submit(cmd_buf_t *cb) {
+    fifo_credits_t fc;
+    fifo_credits(&fc);
+    bool empty = fc.cmd >= CMD_FIFO_DEPTH - CMD_CREDIT_MARGIN;
+    // Every slot without the strict bit (or the 4th slot) ends a command
+    // word; a word takes its credit with its first slot. A slot without the
+    // strict bit also ends the packet; a packet still open at the end of the
+    // recording waits for the slots that close it (or cmd_buf_flush).
+    const uint32_t *words = cb->words + cb->n_sent;
+    uint32_t n_pending = cb->n_words - cb->n_sent;
+    uint32_t n = 0, used = 0, nck = 0;
+    uint32_t n_send = 0, nck_send = 0;
+    uint8_t n_slots = 0;
+    while (n < n_pending) {
+        if (n_slots == 0) {
+            if (used >= fc.cmd && (n_send > 0 || !empty)) break;
+            used++;
+        }
+        nck += slot_nck(words[n], &n_slots);
+        n++;
+        if (!(words[n - 1] >> 31)) {
+            n_send = n;
+            nck_send = nck;
+        }
+    }
+    if (n_send == 0) return 0;
+    bridge_write_words(words, n_send);
+    bridge_flush();
+    cb->nck -= nck_send;
+    cb->n_sent += n_send;
+    if (cb->n_sent == cb->n_words) cmd_buf_reset(cb);
+    return n;
+}
+
+// Command Buffer Push (command + interval)
+static uint32_t cmd_buf_push(cmd_buf_t *cb, uint32_t cmd, uint32_t interval, bool strict) {
+    uint32_t n_words = cmd_n_words(interval, strict);
+    uint32_t first = cb->n_words;
+    uint8_t slots = cb->open_slots;
+    // Grow instead of flushing early: nothing reaches the bridge before the
+    // caller's flush (WRs before their MM2S is armed), and nck stays whole
+    if (cb->n_words + n_words > cb->capacity) {
+        uint32_t capacity = cb->capacity ? cb->capacity : 1;
+        while (capacity < cb->n_words + n_words) capacity *= 2;
+        uint32_t *words = (uint32_t *)realloc(cb->words, capacity * sizeof(uint32_t));
+        if (words == NULL) {
+            perror("Failed to grow command buffer");
+            exit(1);
+        }
+        cb->words = words;
+        cb->capacity = capacity;
+    }
+    // A 128-bit word carries one write data beat, so a strict packet must
+    // not put a host WR and a pattern WR into the same word
+    uint8_t wr_kind = 0;
+    if ((cmd & 0b111) == 4) {
+        wr_kind = ((cmd >> 17) & 0x7) == PATTERN_HOST ? CMD_BUF_WR_HOST : CMD_BUF_WR_PATTERN;
+    }
+    if (wr_kind != 0 && (cb->open_wr & ~wr_kind) != 0) {
+        fprintf(stderr, "Host WR and pattern WR packed into one command word\n");
+        exit(1);
+    }
+    if (strict && cb->open_slots + 1 + interval < 4) {
+        cb->open_slots += 1 + interval;
+        cb->open_wr |= wr_kind;
+    } else if (strict) {
+        cb->open_slots = (cb->open_slots + 1 + interval) % 4;
+        cb->open_wr = 0; // The remaining slots are NOPs
+    } else {
+        cb->open_slots = 0;
+        cb->open_wr = 0;
+    }
+    if (strict) {
+        cb->words[cb->n_words++] = cmd | (1u << 31);
+        for (uint32_t i = 0; i < interval; i++) {
+            cb->words[cb->n_words++] = enc_nop() | (1u << 31);
+        }
+    } else {
+        cb->words[cb->n_words++] = cmd;
+        while (interval > 0) {
+            uint32_t cycles = wait_cycles(interval);
+            cb->words[cb->n_words++] = enc_wait(cycles - 1);
+            interval -= cycles;
+        }
+    }
+    // Non-strict words count whole fabric cycles, strict slots share them
+    uint32_t nck = 0;
+    for (uint32_t i = first; i < cb->n_words; i++) nck += slot_nck(cb->words[i], &slots);
+    cb->nck += nck;
+    return nck;
 }
 
-// Command Send
-void cmd_send(uint32_t cmd, uint32_t interval, bool strict) {
-    // cmd_send_64bit(cmd, interval);
-    cmd_send_32bit(cmd, interval, strict);
+// NOP Command (Buffered)
+uint32_t cmd_buf_nop(cmd_buf_t *cb, uint32_t interval, bool strict) {
+    if (strict) {
+        return cmd_buf_push(cb, enc_nop(), interval, true);
+    }
+    // Fold the interval into the NOP itself
+    uint32_t count = wait_cycles(interval + 1) - 1;
+    return cmd_buf_push(cb, enc_wait(count), interval - count, false);
+}
+
+// Precharge Command (Buffered)
+uint32_t cmd_buf_pre(cmd_buf_t *cb, uint8_t bank_addr, uint8_t rank_addr, bool bank_all, uint32_t interval, bool strict) {
+    return cmd_buf_push(cb, enc_pre(bank_addr, rank_addr, bank_all), interval, strict);
+}
+
+// Activation Command (Buffered)
+uint32_t cmd_buf_act(cmd_buf_t *cb, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, uint32_t interval, bool strict) {
+    return cmd_buf_push(cb, enc_act(bank_addr, row_addr, rank_addr), interval, strict);
+}
+
+// Read Command (Buffered, read data must be received separately)
+uint32_t cmd_buf_rd(cmd_buf_t *cb, uint8_t bank_addr, uint16_t col_addr, uint32_t interval, bool strict) {
+    return cmd_buf_push(cb, enc_rd(bank_addr, col_addr, 0, false), interval, strict);
+}
+
+// Read Command in a Batch (Buffered)
+// Only the data of the last RD of a batch is marked with TLAST, so the whole
+// batch can be received with a single S2MM transfer.
+uint32_t cmd_buf_rd_batch(cmd_buf_t *cb, uint8_t bank_addr, uint16_t col_addr, bool last, uint32_t interval, bool strict) {
+    return cmd_buf_push(cb, enc_rd(bank_addr, col_addr, 0, !last), interval, strict);
+}
+
+// Compare Read Command in a Batch (Buffered)
+// The read data is compared with the pattern in fabric; only mismatch
+// records and a summary (TLAST, after the last RD) are returned.
+uint32_t cmd_buf_rd_compare(cmd_buf_t *cb, uint8_t bank_addr, uint16_t col_addr, uint8_t pattern_id, bool last, uint32_t interval, bool strict) {
+    return cmd_buf_push(cb, enc_rd_compare(bank_addr, col_addr, 0, !last, pattern_id), interval, strict);
+}
+
+// Write Command (Buffered, write data must be sent separately)
+uint32_t cmd_buf_wr(cmd_buf_t *cb, uint8_t bank_addr, uint16_t col_addr, uint32_t interval, bool strict) {
+    return cmd_buf_push(cb, enc_wr(bank_addr, col_addr, 0), interval, strict);
+}
+
+// Pattern Write Command (Buffered)
+// Write data is generated in fabric from the pattern ID and the current seed.
+uint32_t cmd_buf_wr_pattern(cmd_buf_t *cb, uint8_t bank_addr, uint16_t col_addr, uint8_t pattern_id, uint32_t interval, bool strict) {
+    return cmd_buf_push(cb, enc_wr_pattern(bank_addr, col_addr, 0, pattern_id), interval, strict);
+}
+
+// Configuration Command (Buffered)
+uint32_t cmd_buf_cfg(cmd_buf_t *cb, uint8_t reg_addr, uint16_t value, uint32_t interval, bool strict) {
+    return cmd_buf_push(cb, enc_cfg(reg_addr, value), interval, strict);
+}
+
+// Pattern Seed (Buffered, applies to the following pattern WRs)
+uint32_t cmd_buf_pattern_seed(cmd_buf_t *cb, uint32_t seed) {
+    uint32_t nck = 0;
+    nck += cmd_buf_cfg(cb, CFG_SEED_LO, seed & 0xFFFF, 0, false);
+    nck += cmd_buf_cfg(cb, CFG_SEED_HI, seed >> 16, 0, false);
+    return nck;
+}
+
+// Issue Window Mark (Buffered)
+// Restarts the hardware issue window in command order, so the window covers
+// exactly the commands recorded after the mark.
+uint32_t cmd_buf_issue_mark(cmd_buf_t *cb) {
+    return cmd_buf_cfg(cb, CFG_ISSUE_MARK, 0, 0, false);
+}
+
+// Refresh Command (Buffered)
+uint32_t cmd_buf_rf(cmd_buf_t *cb, uint32_t interval, bool strict) {
+    return cmd_buf_push(cb, enc_rf(0), interval, strict);
 }
 
 // NOP Command
 uint32_t nop(uint32_t interval, bool strict) {
-    uint32_t cmd = 0b111; // NOP
-    cmd_send(cmd, interval, strict);
-    uint32_t nck = 1 + interval;
-    return nck;
+    if (strict) {
+        return cmd_send(enc_nop(), interval, true);
+    }
+    // Fold the interval into the NOP itself
+    uint32_t count = wait_cycles(interval + 1) - 1;
+    return cmd_send(enc_wait(count), interval - count, false);
 }
 
 // Precharge Command
 uint32_t pre(uint8_t bank_addr, uint8_t rank_addr, bool bank_all, uint32_t interval, bool strict) {
-    bank_addr &= 0xF; // 4 bits
-    uint32_t cmd = 1 | (bank_addr << 3) | (bank_all << 7); // Precharge
-    cmd_send(cmd, interval, strict);
-    uint32_t nck = 1 + interval;
-    return nck;
+    return cmd_send(enc_pre(bank_addr, rank_addr, bank_all), interval, strict);
 }
 
 // Activation Command
 uint32_t act(uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, uint32_t interval, bool strict) {
-    bank_addr &= 0xF; // 4 bits
-    row_addr &= 0x7FFF; // 17 bits
-    uint32_t cmd = 2 | (bank_addr << 3) | (row_addr << 7); // Activate
-    cmd_send(cmd, interval, strict);
-    uint32_t nck = 1 + interval;
-    return nck;
+    return cmd_send(enc_act(bank_addr, row_addr, rank_addr), interval, strict);
+}
+
+// DMA Drain (both queues, before the synchronous helpers reuse the udmabuf)
+static void dma_drain(void) {
+    dma_send_drain();
+    dma_recv_drain();
 }
 
 // Read Command
-uint32_t rd(uint32_t *buffer, uint8_t bank_addr, uint16_t col_addr, uint32_t interval) {
-    bank_addr &= 0xF; // 4 bits
-    col_addr &= 0x3FF; // 10 bits
-    uint32_t cmd = 3 | (bank_addr << 3) | (col_addr << 7); // Read
-    cmd_send(cmd, interval, false);
+uint32_t rd(uint32_t *buffer, uint8_t bank_addr, uint16_t col_addr, uint32_t interval, bool strict) {
+    dma_drain();
+    uint32_t nck = cmd_send(enc_rd(bank_addr, col_addr, 0, false), interval, strict);
     // Receive data
     dma_recv(dma0_vptr, udmabuf_phys_addr, 16 * sizeof(uint32_t)); // 512 bits
     // Copy data to buffer
     memcpy(buffer, (uint32_t *)udmabuf_vptr, 16 * sizeof(uint32_t)); // 512 bits, 64 bytes
-    uint32_t nck = 1 + interval;
     return nck;
 }
 
 // Write Command
-uint32_t wr(uint32_t *buffer, uint8_t bank_addr, uint16_t col_addr, uint32_t interval) {
-    bank_addr &= 0xF; // 4 bits
-    col_addr &= 0x3FF; // 10 bits
-    uint32_t cmd = 4 | (bank_addr << 3) | (col_addr << 7); // Write
+uint32_t wr(uint32_t *buffer, uint8_t bank_addr, uint16_t col_addr, uint32_t interval, bool strict) {
+    dma_drain();
     // Set data
     uint32_t *ptr = (uint32_t *)udmabuf_vptr;
     for (int i = 0; i < 16; i++) {
@@ -440,98 +1308,813 @@ uint32_t wr(uint32_t *buffer, uint8_t bank_addr, uint16_t col_addr, uint32_t int
     }
     dma_send(dma0_vptr, udmabuf_phys_addr, 16 * sizeof(uint32_t)); // 512 bits, 64 bytes
     // Send command
-    cmd_send(cmd, interval, false);
-    uint32_t nck = 1 + interval;
-    return nck;
+    return cmd_send(enc_wr(bank_addr, col_addr, 0), interval, strict);
 }
 
 // Refresh Command
-uint32_t rf(uint32_t interval) {
-    uint32_t cmd = 5; // Refresh
-    cmd_send(cmd, interval, false);
-    uint32_t nck = 1 + interval;
-    return nck;
+uint32_t rf(uint32_t interval, bool strict) {
+    return cmd_send(enc_rf(0), interval, strict);
 }
 
 // Write Row
+// The whole row is staged in the udmabuf and sent with one MM2S transfer,
+// and PRE/ACT/WRs are submitted to the bridge with one command buffer flush.
 uint32_t write_row(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr) {
-    uint32_t nck = 0;
-    nck += pre(bank_addr, rank_addr, false, nRP, false);
-    nck += act(bank_addr, row_addr, rank_addr, nRCD, false);
+    refresh_service();
+    dma_drain();
+    cmd_buf_t *cb = &row_cb;
+    cmd_buf_pre(cb, bank_addr, rank_addr, false, timing.tRP, false);
+    cmd_buf_act(cb, bank_addr, row_addr, rank_addr, timing.tRCD, false);
     for (int i = 0; i < 128; i++) {
-        nck += wr(data_buf+i*16, bank_addr, i*8, nCCD_L);
+        cmd_buf_wr(cb, bank_addr, i*8, timing.tCCD_L, false);
+    }
+    // Batched data transfer start
+    uint32_t *ptr = (uint32_t *)udmabuf_vptr;
+    for (int i = 0; i < 128; i++) {
+        for (int j = 0; j < 16; j++) {
+            ptr[i*16+j] = data_buf[i*16+j];
+        }
     }
+    dma_send_start(dma0_vptr, udmabuf_phys_addr, 16 * 128 * sizeof(uint32_t)); // Batch transfer
+    // Issue PRE/ACT/WR commands
+    uint32_t nck = cmd_buf_flush(cb);
+    // Wait for DMA transfer completion
+    dma_send_wait(dma0_vptr);
     return nck;
 }
 
-// Write Row
+// Write Row Pattern
+// The whole row is written with pattern WRs, so no write data is moved by
+// the host. gen_pattern() in utils.c is the bit-exact software reference.
+uint32_t write_row_pattern(uint8_t pattern_id, uint32_t seed, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr) {
+    refresh_service();
+    cmd_buf_t *cb = &row_cb;
+    cmd_buf_pattern_seed(cb, seed);
+    cmd_buf_pre(cb, bank_addr, rank_addr, false, timing.tRP, false);
+    cmd_buf_act(cb, bank_addr, row_addr, rank_addr, timing.tRCD, false);
+    for (int i = 0; i < 128; i++) {
+        cmd_buf_wr_pattern(cb, bank_addr, i*8, pattern_id, timing.tCCD_L, false);
+    }
+    return cmd_buf_flush(cb);
+}
+
+// Write Row Batch
 uint32_t write_row_batch(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr) {
+    return write_row(data_buf, bank_addr, row_addr, rank_addr);
+}
+
+// Read Row
+// RDATA FIFO has no backpressure, so RDs are flushed in groups that fit in it
+// and each group is drained before the next one is submitted.
+uint32_t read_row(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr) {
+    refresh_service();
+    dma_drain();
+    cmd_buf_t *cb = &row_cb;
     uint32_t nck = 0;
-    nck += pre(bank_addr, rank_addr, false, nRP, false);
-    nck += act(bank_addr, row_addr, rank_addr, nRCD, false);
+    cmd_buf_pre(cb, bank_addr, rank_addr, false, timing.tRP, false);
+    cmd_buf_act(cb, bank_addr, row_addr, rank_addr, timing.tRCD, false);
+    for (int i = 0; i < 128/READ_GROUP_COLS; i++) {
+        // Refresh between groups (reopens the row if its rank was refreshed)
+        if (i > 0 && (refresh_service() & (1u << rank_addr))) {
+            cmd_buf_act(cb, bank_addr, row_addr, rank_addr, timing.tRCD, false);
+        }
+        // Issue RD commands
+        for (int j = 0; j < READ_GROUP_COLS; j++) {
+            cmd_buf_rd(cb, bank_addr, (i*READ_GROUP_COLS+j)*8, timing.tCCD_L, false);
+        }
+        nck += cmd_buf_flush(cb);
+        // Receive data (RDATA FIFO marks TLAST on every beat)
+        for (int j = 0; j < READ_GROUP_COLS; j++) {
+            dma_recv(dma0_vptr, udmabuf_phys_addr + j * 16 * sizeof(uint32_t), 16 * sizeof(uint32_t)); // 512 bits
+        }
+        // Copy data to buffer
+        memcpy(data_buf+i*READ_GROUP_COLS*16, (uint32_t *)udmabuf_vptr, READ_GROUP_COLS * 16 * sizeof(uint32_t));
+    }
+    return nck;
+}
+
+// Read Row Batch
+// The S2MM transfer for the whole row is armed first, then PRE/ACT/RDs are
+// submitted with one flush. Hardware marks TLAST only on the last RD's data.
+uint32_t read_row_batch(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr) {
+    refresh_service();
+    dma_drain();
+    cmd_buf_t *cb = &row_cb;
+    cmd_buf_pre(cb, bank_addr, rank_addr, false, timing.tRP, false);
+    cmd_buf_act(cb, bank_addr, row_addr, rank_addr, timing.tRCD, false);
+    for (int i = 0; i < 128; i++) {
+        cmd_buf_rd_batch(cb, bank_addr, i*8, i == 127, timing.tCCD_L, false);
+    }
     // Batched data transfer start
-    uint32_t *ptr = (uint32_t *)udmabuf_vptr;
+    dma_recv_start(dma0_vptr, udmabuf_phys_addr, 16 * 128 * sizeof(uint32_t)); // Batch transfer
+    // Issue PRE/ACT/RD commands
+    uint32_t nck = cmd_buf_flush(cb);
+    // Wait for DMA transfer completion
+    dma_recv_wait(dma0_vptr);
+    // Copy data to buffer
+    memcpy(data_buf, (uint32_t *)udmabuf_vptr, 16 * 128 * sizeof(uint32_t));
+    return nck;
+}
+
+// Read Row Compare
+// The row is read with compare RDs, so the fabric checks it against the
+// pattern written by write_row_pattern and a clean row returns one beat.
+// mask_buf (optional, one row) receives read data XOR expected data of the
+// mismatched columns and zero elsewhere.
+uint32_t read_row_compare(uint8_t pattern_id, uint32_t seed, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, rd_compare_t *result, uint32_t *mask_buf) {
+    refresh_service();
+    dma_drain();
+    if (udmabuf_size < CMP_MAX_BYTES + 2 * DMA_RING_BYTES) {
+        fprintf(stderr, "udmabuf too small for compare records: %u bytes\n", udmabuf_size);
+        exit(1);
+    }
+    cmd_buf_t *cb = &row_cb;
+    cmd_buf_pattern_seed(cb, seed);
+    cmd_buf_pre(cb, bank_addr, rank_addr, false, timing.tRP, false);
+    cmd_buf_act(cb, bank_addr, row_addr, rank_addr, timing.tRCD, false);
+    for (int i = 0; i < 128; i++) {
+        cmd_buf_rd_compare(cb, bank_addr, i*8, pattern_id, i == 127, timing.tCCD_L, false);
+    }
+    // Records end with the summary beat (TLAST)
+    dma_recv_start(dma0_vptr, udmabuf_phys_addr, CMP_MAX_BYTES);
+    // Issue PRE/ACT/RD commands
+    uint32_t nck = cmd_buf_flush(cb);
+    // Wait for DMA transfer completion
+    dma_recv_wait(dma0_vptr);
+    // Parse records
+    if (mask_buf) {
+        memset(mask_buf, 0, DMA_ROW_BYTES);
+    }
+    const uint32_t *beat = (const uint32_t *)udmabuf_vptr;
+    const uint32_t *end = beat + CMP_MAX_BYTES / sizeof(uint32_t);
+    while (beat < end && beat[0] == CMP_REC_MISMATCH) {
+        uint32_t col_addr = beat[3] & 0x3FF;
+        if (mask_buf) {
+            memcpy(mask_buf + (col_addr / 8) * 16, beat + 16, 16 * sizeof(uint32_t));
+        }
+        beat += 2 * 16;
+    }
+    if (beat >= end || beat[0] != CMP_REC_SUMMARY) {
+        fprintf(stderr, "Invalid compare record at beat %ld\n", (long)(beat - (const uint32_t *)udmabuf_vptr) / 16);
+        exit(1);
+    }
+    result->beats = beat[1];
+    result->mismatches = beat[2];
+    result->flips = beat[3];
+    result->dropped = beat[4];
+    return nck;
+}
+
+// Write Row Issue (data already staged in the next MM2S slot)
+static uint32_t write_row_issue(uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr) {
+    refresh_service();
+    cmd_buf_t *cb = &row_cb;
+    cmd_buf_pre(cb, bank_addr, rank_addr, false, timing.tRP, false);
+    cmd_buf_act(cb, bank_addr, row_addr, rank_addr, timing.tRCD, false);
+    for (int i = 0; i < 128; i++) {
+        cmd_buf_wr(cb, bank_addr, i*8, timing.tCCD_L, false);
+    }
+    dma_send_queue(DMA_ROW_BYTES);
+    // Issue PRE/ACT/WR commands
+    return cmd_buf_flush(cb);
+}
+
+// Write Row Queue
+// Same as write_row, but the row is staged in the next MM2S slot and the
+// call returns without waiting, so consecutive rows stream back to back.
+uint32_t write_row_queue(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr) {
+    // Stage data in the next free slot
+    uint32_t *ptr = dma_send_slot();
     for (int i = 0; i < 128; i++) {
         for (int j = 0; j < 16; j++) {
             ptr[i*16+j] = data_buf[i*16+j];
         }
     }
-    dma_send_start(dma0_vptr, udmabuf_phys_addr, 16 * 128 * sizeof(uint32_t)); // Batch transfer
-    // Issue WR commands
-    bank_addr &= 0xF; // 4 bits
+    return write_row_issue(bank_addr, row_addr, rank_addr);
+}
+
+// Read Row Queue
+// Arms an S2MM transfer into the next slot and issues PRE/ACT/RDs without
+// waiting. Rows are returned in order by read_row_complete.
+uint32_t read_row_queue(uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr) {
+    refresh_service();
+    cmd_buf_t *cb = &row_cb;
+    cmd_buf_pre(cb, bank_addr, rank_addr, false, timing.tRP, false);
+    cmd_buf_act(cb, bank_addr, row_addr, rank_addr, timing.tRCD, false);
+    for (int i = 0; i < 128; i++) {
+        cmd_buf_rd_batch(cb, bank_addr, i*8, i == 127, timing.tCCD_L, false);
+    }
+    dma_recv_queue(DMA_ROW_BYTES);
+    // Issue PRE/ACT/RD commands
+    return cmd_buf_flush(cb);
+}
+
+// Read Row Complete (oldest queued row)
+void read_row_complete(uint32_t *data_buf) {
+    uint32_t *ptr = dma_recv_complete();
+    memcpy(data_buf, ptr, DMA_ROW_BYTES);
+    dma_recv_release();
+}
+
+// Interleaved Row Commands
+typedef enum {
+    ILV_WR,         // Host data WRs
+    ILV_WR_PATTERN, // Pattern WRs
+    ILV_RD_BATCH    // RDs, TLAST on the last one
+} ilv_op_t;
+
+// Interleaved Rows Check (distinct banks, rows fit in the udmabuf)
+static void rows_interleaved_check(const uint8_t *bank_addrs, uint8_t n_banks) {
+    uint32_t seen = 0;
+    if (n_banks < 1 || n_banks > ILV_MAX_BANKS) {
+        fprintf(stderr, "Invalid number of interleaved banks: %u\n", n_banks);
+        exit(1);
+    }
+    for (uint8_t b = 0; b < n_banks; b++) {
+        if (bank_addrs[b] >= 16 || (seen & (1u << bank_addrs[b]))) {
+            fprintf(stderr, "Invalid interleaved bank: %u\n", bank_addrs[b]);
+            exit(1);
+        }
+        seen |= 1u << bank_addrs[b];
+    }
+    if (udmabuf_size < n_banks * DMA_ROW_BYTES + 2 * DMA_RING_BYTES) {
+        fprintf(stderr, "udmabuf too small for %u interleaved rows: %u bytes\n", n_banks, udmabuf_size);
+        exit(1);
+    }
+}
+
+// Interleaved Rows Flush
+// Compacts the recorded commands into ilv_out and submits them.
+static uint32_t rows_interleaved_flush(cmd_buf_t *cb) {
+    if (timing_compact(&timing, cb, &ilv_out, NULL) != 0) {
+        exit(1);
+    }
+    cmd_buf_reset(cb);
+    return cmd_buf_flush(&ilv_out);
+}
+
+// RDATA FIFO Drain
+// Waits until the issued commands are out and the RDATA FIFO is empty (the
+// S2MM transfer must be armed). Beats of the last RDs may still be in the
+// read pipeline, so a group of READ_GROUP_COLS RDs can follow safely.
+static bool rdata_fifo_empty(uint32_t state) {
+    return STATE_RDATA_FIFO(state) == 0;
+}
+
+static void rdata_fifo_drain(void) {
+    cmd_drain();
+    state_wait(rdata_fifo_empty, "RDATA FIFO drain");
+}
+
+// Interleaved Rows Issue
+// PRE and ACT every bank, then the column commands round robin over the
+// banks (column i of every row before column i + 1). Only the order is
+// recorded; timing_compact() spaces the commands at the minimum of the
+// active profile, so consecutive banks in different bank groups run at
+// tCCD_S and the data bus stays busy. The stream ends settled.
+// RDs go out READ_GROUP_COLS at a time: RDs at tCCD_S return a beat every
+// 4 nCK, faster than the 100MHz DMA empties the 16-deep RDATA FIFO, so
+// each group waits for the FIFO to empty before the next one is issued.
+static uint32_t rows_interleaved_issue(ilv_op_t op, uint8_t pattern_id, const uint8_t *bank_addrs, uint8_t n_banks, uint32_t row_addr, uint8_t rank_addr) {
+    cmd_buf_t *cb = &ilv_cb;
+    uint32_t nck = 0;
+    uint32_t n_rds = 0;
+    for (uint8_t b = 0; b < n_banks; b++) {
+        cmd_buf_pre(cb, bank_addrs[b], rank_addr, false, 0, false);
+    }
+    for (uint8_t b = 0; b < n_banks; b++) {
+        cmd_buf_act(cb, bank_addrs[b], row_addr, rank_addr, 0, false);
+    }
+    for (int i = 0; i < 128; i++) {
+        for (uint8_t b = 0; b < n_banks; b++) {
+            switch (op) {
+                case ILV_WR:
+                    cmd_buf_wr(cb, bank_addrs[b], i*8, 0, false);
+                    break;
+                case ILV_WR_PATTERN:
+                    cmd_buf_wr_pattern(cb, bank_addrs[b], i*8, pattern_id, 0, false);
+                    break;
+                case ILV_RD_BATCH:
+                    cmd_buf_rd_batch(cb, bank_addrs[b], i*8, i == 127 && b == n_banks - 1, 0, false);
+                    if (++n_rds % READ_GROUP_COLS == 0) {
+                        nck += rows_interleaved_flush(cb);
+                        rdata_fifo_drain();
+                        // Refresh between groups (reopens the rows)
+                        if (n_rds < 128u * n_banks && (refresh_service() & (1u << rank_addr))) {
+                            for (uint8_t a = 0; a < n_banks; a++) {
+                                cmd_buf_act(cb, bank_addrs[a], row_addr, rank_addr, 0, false);
+                            }
+                        }
+                    }
+                    break;
+            }
+        }
+    }
+    // Issue PRE/ACT/column commands (the rest of them for RDs)
+    if (cb->n_words > 0) nck += rows_interleaved_flush(cb);
+    return nck;
+}
+
+// Write Rows Interleaved
+// Writes the same row in n_banks banks with column WRs interleaved across
+// them. Banks should alternate bank groups (e.g. 0, 4, 8, 12, 1, 5, ...),
+// as WRs within a group still wait tCCD_L. data_buf holds the rows back to
+// back in bank_addrs order; they are staged in WR order and sent with one
+// MM2S transfer.
+uint32_t write_rows_interleaved(uint32_t *data_buf, const uint8_t *bank_addrs, uint8_t n_banks, uint32_t row_addr, uint8_t rank_addr) {
+    refresh_service();
+    rows_interleaved_check(bank_addrs, n_banks);
+    dma_drain();
+    // Stage data (column by column across the rows)
+    uint32_t *ptr = (uint32_t *)udmabuf_vptr;
     for (int i = 0; i < 128; i++) {
-        int col_addr = i*8 & 0x3FF;
-        uint32_t cmd = 4 | (bank_addr << 3) | (col_addr << 7); // Write
-        // Send command
-        cmd_send(cmd, nCCD_L, false);
-        nck += 1 + nCCD_L;
+        for (uint8_t b = 0; b < n_banks; b++) {
+            memcpy(ptr + (i*n_banks + b)*16, data_buf + b*128*16 + i*16, 16 * sizeof(uint32_t));
+        }
     }
+    dma_send_start(dma0_vptr, udmabuf_phys_addr, n_banks * DMA_ROW_BYTES); // Batch transfer
+    uint32_t nck = rows_interleaved_issue(ILV_WR, 0, bank_addrs, n_banks, row_addr, rank_addr);
     // Wait for DMA transfer completion
     dma_send_wait(dma0_vptr);
     return nck;
 }
 
-// Read Row
-uint32_t read_row(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr) {
-    uint32_t nck = 0;
-    nck += pre(bank_addr, rank_addr, false, nRP, false);
-    nck += act(bank_addr, row_addr, rank_addr, nRCD, false);
+// Write Rows Interleaved Pattern
+// Same as write_rows_interleaved with pattern WRs (see write_row_pattern),
+// so no write data is moved by the host. Meant for full-DIMM initialization.
+uint32_t write_rows_interleaved_pattern(uint8_t pattern_id, uint32_t seed, const uint8_t *bank_addrs, uint8_t n_banks, uint32_t row_addr, uint8_t rank_addr) {
+    refresh_service();
+    rows_interleaved_check(bank_addrs, n_banks);
+    cmd_buf_pattern_seed(&ilv_cb, seed);
+    return rows_interleaved_issue(ILV_WR_PATTERN, pattern_id, bank_addrs, n_banks, row_addr, rank_addr);
+}
+
+// Read Rows Interleaved
+// Reads the same row in n_banks banks with column RDs interleaved across
+// them (bank order as in write_rows_interleaved). One S2MM transfer is
+// armed for all rows, which must keep up with the RDATA FIFO (RDATA
+// overflows in perf_counters_t). data_buf receives the rows back to back in
+// bank_addrs order. Every READ_GROUP_COLS RDs cost a GPIO round trip and the
+// settle tail of a compacted stream, so on hardware the read bus stays well
+// below the interleaved writes (the DDR4 model does not charge host time).
+uint32_t read_rows_interleaved(uint32_t *data_buf, const uint8_t *bank_addrs, uint8_t n_banks, uint32_t row_addr, uint8_t rank_addr) {
+    refresh_service();
+    rows_interleaved_check(bank_addrs, n_banks);
+    dma_drain();
+    dma_recv_start(dma0_vptr, udmabuf_phys_addr, n_banks * DMA_ROW_BYTES); // Batch transfer
+    uint32_t nck = rows_interleaved_issue(ILV_RD_BATCH, 0, bank_addrs, n_banks, row_addr, rank_addr);
+    // Wait for DMA transfer completion
+    dma_recv_wait(dma0_vptr);
+    // Copy data to buffer (beats arrive column by column across the rows)
+    const uint32_t *ptr = (const uint32_t *)udmabuf_vptr;
     for (int i = 0; i < 128; i++) {
-        nck += rd(data_buf+i*16, bank_addr, i*8, nCCD_L);
+        for (uint8_t b = 0; b < n_banks; b++) {
+            memcpy(data_buf + b*128*16 + i*16, ptr + (i*n_banks + b)*16, 16 * sizeof(uint32_t));
+        }
     }
     return nck;
 }
 
-// // Read Row Batch
-// uint32_t read_row_batch(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr) {
-//     uint32_t nck = 0;
-//     nck += pre(bank_addr, rank_addr, false, nRP, false);
-//     nck += act(bank_addr, row_addr, rank_addr, nRCD, false);
-//     int n_batches = 16; // the max value of n_batches is equal to the RDATA FIFO depth.
-//     for (int i = 0; i < 128/n_batches; i++) {
-//         // Issue RD commands
-//         for (int j = 0; j < n_batches; j++) {
-//             uint32_t col_addr = (i*n_batches+j)*8 & 0x3FF;
-//             uint32_t rd_cmd = 3 | (bank_addr << 3) | (col_addr << 7); // Read
-//             cmd_send(rd_cmd, nCCD_L);
-//             nck += 1 + nCCD_L;
-//         }
-//         // Batched DMA transfer start
-//         dma_recv(dma0_vptr, udmabuf_phys_addr, n_batches * 16 * sizeof(uint32_t)); // 512 bits * n_batches
-//         // Copy data to buffer
-//         memcpy(data_buf+i*n_batches*16, (uint32_t *)udmabuf_vptr, n_batches * 16 * sizeof(uint32_t)); // 512 bits * n_batches, 64 bytes * n_batches
-//     }
-//     return nck;
-// }
+// Row Pipeline Depth (rows in flight, limited by the DMA queue slots)
+static uint32_t row_pipeline_depth(uint32_t depth) {
+    if (depth < 1) depth = 1;
+    if (depth > dma_slots) depth = dma_slots;
+    return depth;
+}
 
-// All Bank Refresh
-uint32_t all_bank_refresh(uint8_t rank_addr) {
+// Write Rows (Pipelined)
+// Row N+1 is generated straight into its DMA slot while row N is in flight;
+// at most depth rows are queued. Rows are visited rank by rank, bank by
+// bank, row by row.
+uint32_t write_rows_pipelined(uint8_t n_ranks, uint8_t n_banks, uint32_t n_rows, uint32_t depth, bool refresh, row_gen_fn_t gen, void *arg) {
     uint32_t nck = 0;
-    nck += pre(0, rank_addr, true, nRP, false); // precharge all banks
-    nck += rf(nRFC); // refresh
+    depth = row_pipeline_depth(depth);
+    dma_drain();
+    for (uint8_t rank_addr = 0; rank_addr < n_ranks; rank_addr++) {
+        for (uint8_t bank_addr = 0; bank_addr < n_banks; bank_addr++) {
+            for (uint32_t row_addr = 0; row_addr < n_rows; row_addr++) {
+                // Keep at most depth rows in flight
+                while (mm2s_q.count >= depth) {
+                    dma_queue_wait(&mm2s_q);
+                    dma_queue_pop(&mm2s_q);
+                }
+                gen(dma_send_slot(), bank_addr, row_addr, rank_addr, arg);
+                nck += write_row_issue(bank_addr, row_addr, rank_addr);
+                if (refresh) nck += all_bank_refresh(rank_addr);
+            }
+        }
+    }
+    dma_send_drain();
     return nck;
 }
 
+// Read Rows (Pipelined)
+// Up to depth rows are read ahead while the oldest one is checked. Stops at
+// the first row the callback rejects and returns -1.
+int read_rows_pipelined(uint8_t n_ranks, uint8_t n_banks, uint32_t n_rows, uint32_t depth, bool refresh, row_check_fn_t check, void *arg) {
+    uint32_t data_buf[16*128];
+    const uint32_t total = n_ranks * n_banks * n_rows;
+    uint32_t n_issued = 0;
+    depth = row_pipeline_depth(depth);
+    dma_drain();
+    for (uint32_t n_checked = 0; n_checked < total; n_checked++) {
+        // Read ahead
+        while (n_issued < total && s2mm_q.count < depth) {
+            uint32_t row_addr = n_issued % n_rows;
+            uint8_t bank_addr = (n_issued / n_rows) % n_banks;
+            uint8_t rank_addr = n_issued / (n_rows * n_banks);
+            read_row_queue(bank_addr, row_addr, rank_addr);
+            if (refresh) all_bank_refresh(rank_addr);
+            n_issued++;
+        }
+        // Check the oldest row
+        uint32_t row_addr = n_checked % n_rows;
+        uint8_t bank_addr = (n_checked / n_rows) % n_banks;
+        uint8_t rank_addr = n_checked / (n_rows * n_banks);
+        read_row_complete(data_buf);
+        if (check(data_buf, bank_addr, row_addr, rank_addr, arg) != 0) {
+            dma_recv_drain();
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Refresh Burst (PREA, then n_refs REFs)
+static uint32_t refresh_issue(uint8_t rank_addr, uint32_t n_refs) {
+    cmd_buf_t *cb = &row_cb;
+    cmd_buf_pre(cb, 0, rank_addr, true, timing.tRP, false); // precharge all banks
+    for (uint32_t i = 0; i < n_refs; i++) {
+        cmd_buf_push(cb, enc_rf(rank_addr), timing.tRFC, false); // refresh
+    }
+    return cmd_buf_flush(cb);
+}
+
+// Refresh Elapsed tREFI Intervals (since refresh_config)
+// DRAM time runs whether or not commands are submitted, so it is taken from
+// the host clock. REFs land behind the commands already queued in fabric,
+// which the postpone budget covers.
+static uint64_t refresh_intervals(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double ns = (now.tv_sec - refresh_t0.tv_sec) * 1e9 + (now.tv_nsec - refresh_t0.tv_nsec);
+    return (uint64_t)(ns / timing.tCK) / timing.tREFI;
+}
+
+// Refresh Service
+// Called by the row helpers before they submit anything (and between the RD
+// groups of the long reads). Every rank that owes at least refresh_postpone
+// REFs gets a PREA and all of them, in bursts of up to REFRESH_MAX_POSTPONE
+// + 1. REFs owed beyond that were due past what DDR4 allows to postpone:
+// they are still issued, and counted as late (the retention window may
+// have been exceeded). Returns a mask of the refreshed ranks, whose banks
+// are now closed.
+static uint32_t refresh_service(void) {
+    uint32_t refreshed = 0;
+    if (refresh_mode != REFRESH_AUTO) {
+        return 0;
+    }
+    uint64_t due = refresh_intervals();
+    for (uint8_t rank_addr = 0; rank_addr < refresh_ranks; rank_addr++) {
+        if (due < refresh_done[rank_addr] + refresh_postpone) {
+            continue;
+        }
+        uint64_t owed = due - refresh_done[rank_addr];
+        if (owed > REFRESH_MAX_POSTPONE + 1) {
+            refresh_st.late += owed - (REFRESH_MAX_POSTPONE + 1);
+        }
+        refresh_st.refs += owed;
+        while (owed > 0) {
+            uint32_t n = owed > REFRESH_MAX_POSTPONE + 1 ? REFRESH_MAX_POSTPONE + 1 : (uint32_t)owed;
+            refresh_issue(rank_addr, n);
+            refresh_st.bursts++;
+            owed -= n;
+        }
+        refresh_done[rank_addr] = due;
+        refreshed |= 1u << rank_addr;
+    }
+    return refreshed;
+}
+
+// Refresh Configure
+// REFRESH_MANUAL: only all_bank_refresh() refreshes (default).
+// REFRESH_AUTO: the row helpers insert PREA + REF per rank as tREFI deadlines
+//   pass, collecting postpone (1 to 8, as DDR4 allows) REFs per burst.
+//   Deadlines run on the host clock and are checked by the row helpers
+//   (also between the RD groups of read_row and read_rows_interleaved) and
+//   prog_start only (see api.h).
+// REFRESH_OFF: no refresh at all, all_bank_refresh() included (retention
+//   experiments).
+// Deadlines and statistics restart from this call.
+int refresh_config(refresh_mode_t mode, uint8_t n_ranks, uint32_t postpone) {
+    if (n_ranks < 1 || n_ranks > REFRESH_MAX_RANKS || postpone < 1 || postpone > REFRESH_MAX_POSTPONE) {
+        fprintf(stderr, "Invalid refresh configuration: %u ranks, postpone %u\n", n_ranks, postpone);
+        return -1;
+    }
+    refresh_mode = mode;
+    refresh_ranks = n_ranks;
+    refresh_postpone = postpone;
+    clock_gettime(CLOCK_MONOTONIC, &refresh_t0);
+    memset(refresh_done, 0, sizeof(refresh_done));
+    memset(&refresh_st, 0, sizeof(refresh_st));
+    return 0;
+}
+
+// Refresh Statistics (since refresh_config)
+void refresh_stats(refresh_stats_t *st) {
+    *st = refresh_st;
+}
+
+// All Bank Refresh
+// Counts towards the tREFI schedule; does nothing with REFRESH_OFF.
+uint32_t all_bank_refresh(uint8_t rank_addr) {
+    if (refresh_mode == REFRESH_OFF) {
+        return 0;
+    }
+    if (rank_addr < REFRESH_MAX_RANKS) {
+        refresh_done[rank_addr]++;
+    }
+    return refresh_issue(rank_addr, 1);
+}
+
+// Program Initialize
+int prog_init(prog_t *pg, uint32_t capacity) {
+    if (capacity > IMEM_DEPTH) {
+        fprintf(stderr, "Program does not fit in IMEM: %u instructions\n", capacity);
+        return -1;
+    }
+    pg->instrs = (uint64_t *)malloc(capacity * sizeof(uint64_t));
+    if (pg->instrs == NULL) {
+        perror("Failed to allocate program");
+        return -1;
+    }
+    pg->n_instrs = 0;
+    pg->capacity = capacity;
+    return 0;
+}
+
+// Program Free
+void prog_free(prog_t *pg) {
+    free(pg->instrs);
+    pg->instrs = NULL;
+    pg->n_instrs = 0;
+    pg->capacity = 0;
+}
+
+// Program Reset (drop recorded instructions)
+void prog_reset(prog_t *pg) {
+    pg->n_instrs = 0;
+}
+
+// Program Push (returns the IMEM offset of the instruction)
+static uint32_t prog_push(prog_t *pg, uint64_t instr) {
+    if (pg->n_instrs >= pg->capacity) {
+        fprintf(stderr, "Program is full: %u instructions\n", pg->capacity);
+        exit(1);
+    }
+    pg->instrs[pg->n_instrs] = instr;
+    return pg->n_instrs++;
+}
+
+// Program Command (command + interval, counters substituted per uses)
+// The next command follows 1 + interval cycles later, as with cmd_buf_push.
+static uint32_t prog_cmd(prog_t *pg, uint32_t cmd, uint32_t interval, uint8_t uses) {
+    if (interval > PROG_WAIT_MAX) {
+        fprintf(stderr, "Program interval is too long: %u cycles\n", interval);
+        exit(1);
+    }
+    uint64_t instr = (OP_CMD << 60) | ((uint64_t)interval << 32) | cmd;
+    if (uses & PROG_USE_BANK) instr |= 1ull << 57;
+    if (uses & PROG_USE_ROW)  instr |= 1ull << 58;
+    if (uses & PROG_USE_COL)  instr |= 1ull << 59;
+    return prog_push(pg, instr);
+}
+
+// NOP Instruction
+uint32_t prog_nop(prog_t *pg, uint32_t interval) {
+    return prog_cmd(pg, enc_nop(), interval, 0);
+}
+
+// Precharge Instruction
+uint32_t prog_pre(prog_t *pg, uint8_t bank_addr, uint8_t rank_addr, bool bank_all, uint32_t interval, uint8_t uses) {
+    return prog_cmd(pg, enc_pre(bank_addr, rank_addr, bank_all), interval, uses);
+}
+
+// Activation Instruction
+uint32_t prog_act(prog_t *pg, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, uint32_t interval, uint8_t uses) {
+    return prog_cmd(pg, enc_act(bank_addr, row_addr, rank_addr), interval, uses);
+}
+
+// Read Instruction (pattern_id != 0: compared in fabric; last: TLAST)
+uint32_t prog_rd(prog_t *pg, uint8_t bank_addr, uint16_t col_addr, uint8_t pattern_id, bool last, uint32_t interval, uint8_t uses) {
+    return prog_cmd(pg, enc_rd_compare(bank_addr, col_addr, 0, !last, pattern_id), interval, uses);
+}
+
+// Write Instruction (pattern_id == 0 consumes host write data)
+uint32_t prog_wr(prog_t *pg, uint8_t bank_addr, uint16_t col_addr, uint8_t pattern_id, uint32_t interval, uint8_t uses) {
+    return prog_cmd(pg, enc_wr_pattern(bank_addr, col_addr, 0, pattern_id), interval, uses);
+}
+
+// Refresh Instruction
+uint32_t prog_rf(prog_t *pg, uint32_t interval) {
+    return prog_cmd(pg, enc_rf(0), interval, 0);
+}
+
+// Set Register Instruction
+uint32_t prog_set(prog_t *pg, prog_reg_t reg, uint32_t value) {
+    return prog_push(pg, (OP_SET << 60) | ((uint64_t)(reg & 0x7) << 48) | value);
+}
+
+// Add Register Instruction
+uint32_t prog_add(prog_t *pg, prog_reg_t reg, uint32_t value) {
+    return prog_push(pg, (OP_ADD << 60) | ((uint64_t)(reg & 0x7) << 48) | value);
+}
+
+// Loop Instruction
+// Decrements the counter and jumps to target unless it reaches zero, so a
+// body ending with LOOP runs n times after prog_set(counter, n), n >= 1.
+uint32_t prog_loop(prog_t *pg, prog_reg_t counter, uint32_t target) {
+    return prog_push(pg, (OP_LOOP << 60) | ((uint64_t)(counter & 0x7) << 48) | (target & (IMEM_DEPTH - 1)));
+}
+
+// Jump Instruction
+uint32_t prog_jump(prog_t *pg, uint32_t target) {
+    return prog_push(pg, (OP_JUMP << 60) | (target & (IMEM_DEPTH - 1)));
+}
+
+// Halt Instruction (ends the program)
+uint32_t prog_halt(prog_t *pg) {
+    return prog_push(pg, OP_HALT << 60);
+}
+
+// Program Upload
+// Writes the program to IMEM at imem_addr with CFG commands, one command
+// word per instruction. Branch targets are IMEM addresses, so a program
+// uploaded at a non-zero address must use targets offset by imem_addr.
+void prog_upload(const prog_t *pg, uint32_t imem_addr) {
+    if (imem_addr + pg->n_instrs > IMEM_DEPTH) {
+        fprintf(stderr, "Program does not fit in IMEM at %u: %u instructions\n", imem_addr, pg->n_instrs);
+        exit(1);
+    }
+    cmd_buf_t *cb = &row_cb;
+    cmd_buf_cfg(cb, CFG_IMEM_ADDR, imem_addr, 0, false);
+    for (uint32_t i = 0; i < pg->n_instrs; i++) {
+        uint64_t instr = pg->instrs[i];
+        // Strict chain keeps the four parts in one command word
+        cmd_buf_cfg(cb, CFG_INSTR_0, instr & 0xFFFF, 0, true);
+        cmd_buf_cfg(cb, CFG_INSTR_1, (instr >> 16) & 0xFFFF, 0, true);
+        cmd_buf_cfg(cb, CFG_INSTR_2, (instr >> 32) & 0xFFFF, 0, true);
+        cmd_buf_cfg(cb, CFG_INSTR_3, (instr >> 48) & 0xFFFF, 0, false);
+    }
+    cmd_buf_flush(cb);
+}
+
+static uint32_t prog_done_state; // Done toggle expected by prog_wait
+
+// Program Start
+// Host commands submitted after this wait in the command FIFO until the
+// program halts. Due REFs go out first; the program itself gets no REFs
+// from the scheduler (see refresh_config).
+void prog_start(uint32_t imem_addr) {
+    refresh_service();
+    prog_done_state = ~gpio_read(1, false) & STATE_PROG_DONE;
+    cmd_buf_t *cb = &row_cb;
+    cmd_buf_cfg(cb, CFG_START, imem_addr & (IMEM_DEPTH - 1), 0, false);
+    cmd_buf_flush(cb);
+}
+
+// Program Wait (until the program started last has halted)
+void prog_wait() {
+    uint32_t state;
+    do {
+        state = gpio_read(1, false);
+    } while ((state & STATE_PROG_RUNNING) || (state & STATE_PROG_DONE) != prog_done_state);
+}
+
+// Performance Counter Read (one 32-bit half of a shadow counter)
+// The state is synchronized across two clock domains, so it is read until
+// two consecutive reads agree (shadows do not change between snapshots).
+// A value that keeps changing means the view is not showing a shadow.
+static uint32_t perf_read(uint32_t index) {
+    gpio_write(2, CTRL_PERF_VIEW | CTRL_PERF_INDEX(index), false);
+    uint32_t prev = gpio_read(1, false);
+    for (uint32_t i = 0; i < PERF_READ_TRIES; i++) {
+        uint32_t data = gpio_read(1, false);
+        if (data == prev) return data;
+        prev = data;
+    }
+    fprintf(stderr, "Performance counter %u did not settle: 0x%08X\n", index, prev);
+    gpio_write(2, 0, false);
+    exit(1);
+}
+
+// Performance Counters Clear
+void perf_clear() {
+    gpio_write(2, CTRL_PERF_CLEAR, false);
+    gpio_write(2, 0, false);
+}
+
+// Performance Counters Snapshot
+// Counters are copied to shadows at once in fabric and then read out, so the
+// values are consistent with each other.
+void perf_snapshot(perf_counters_t *pc) {
+    uint64_t values[PERF_COUNTERS];
+    gpio_write(2, CTRL_PERF_SNAPSHOT, false);
+    gpio_write(2, 0, false);
+    for (int n = 0; n < PERF_COUNTERS; n++) {
+        uint32_t lo = perf_read(2*n);
+        uint32_t hi = perf_read(2*n + 1);
+        values[n] = ((uint64_t)hi << 32) | lo;
+    }
+    gpio_write(2, 0, false); // Back to the default state view
+    pc->cycles             = values[0];
+    pc->cmd_words          = values[1];
+    pc->wdata_beats        = values[2];
+    pc->issued_words       = values[3];
+    pc->wr_words           = values[4];
+    pc->wdata_stall_cycles = values[5];
+    pc->wait_cycles        = values[6];
+    pc->cmd_empty_cycles   = values[7];
+    pc->rdata_overflows    = values[8];
+    pc->n_act              = values[9];
+    pc->n_pre              = values[10];
+    pc->n_rd               = values[11];
+    pc->n_wr               = values[12];
+    pc->n_ref              = values[13];
+    pc->n_zq               = values[14];
+    pc->rd_beats           = values[15];
+    pc->first_issue        = values[16];
+    pc->last_issue         = values[17];
+}
+
+// Issue Window Length (DRAM cycles from the first to the last non-NOP
+// command of the window, 0 if nothing was issued)
+uint64_t perf_issue_nck(const perf_counters_t *pc) {
+    if (pc->last_issue < pc->first_issue || (pc->first_issue == 0 && pc->last_issue == 0)) {
+        return 0;
+    }
+    return pc->last_issue - pc->first_issue + 1;
+}
+
+// Issue Window Mark
+void issue_mark() {
+    cmd_send(enc_cfg(CFG_ISSUE_MARK, 0), 0, false);
+}
+
+// Command Drain (until every submitted command has issued)
+// Waits for the CMD FIFO to empty, for the scheduler to release its held
+// word (WAIT idle cycles included) and for a running program to halt.
+// Programs that run longer than DRAIN_TIMEOUT_MS need prog_wait instead.
+static bool cmd_drained(uint32_t state) {
+    return STATE_CMD_FIFO(state) == 0 && !(state & (STATE_PIPE_BUSY | STATE_PROG_RUNNING));
+}
+
+void cmd_drain() {
+    state_wait(cmd_drained, "Command drain");
+}
+
+// FIFO Credits
+// Free CMD FIFO entries from the GPIO state. Commands written before the call
+// are flushed first, so they are counted.
+// The state word carries the FIFO counts only in the default view. A perf or
+// debug view selected by the caller is left for the read and restored after
+// it; the first read after the switch can still show the old view (two-stage
+// synchronizers both ways) and is dropped. Not safe against perf_snapshot
+// running on another thread, which switches the view itself.
+void fifo_credits(fifo_credits_t *fc) {
+    uint32_t ctrl = gpio_ctrl;
+    uint32_t view = ctrl & (CTRL_DEBUG_VIEW | CTRL_PERF_VIEW);
+    bridge_flush();
+    if (view) {
+        gpio_write(2, ctrl & ~view, false);
+        gpio_read(1, false);
+    }
+    uint32_t state = gpio_read(1, false);
+    if (view) gpio_write(2, ctrl, false);
+    uint32_t cmd_used = STATE_CMD_FIFO(state) + CMD_CREDIT_MARGIN;
+    fc->cmd = cmd_used < CMD_FIFO_DEPTH ? CMD_FIFO_DEPTH - cmd_used : 0;
+}
+
+// Performance Counters Print
+// Cycles without a command word to issue point at the host (or the DMA when
+// WRs wait for data); WAIT idle cycles are DRAM timing.
+void perf_print(const perf_counters_t *pc) {
+    double cycles = pc->cycles ? (double)pc->cycles : 1.0;
+    printf("Cycles: %llu\n", (unsigned long long)pc->cycles);
+    printf("  Issued words: %llu (%.1f%%), WAIT idle: %.1f%%, CMD empty: %.1f%%, WDATA stall: %.1f%%\n",
+           (unsigned long long)pc->issued_words, 100.0 * pc->issued_words / cycles,
+           100.0 * pc->wait_cycles / cycles, 100.0 * pc->cmd_empty_cycles / cycles,
+           100.0 * pc->wdata_stall_cycles / cycles);
+    printf("  Command words: %llu, WDATA beats: %llu, WR words: %llu\n",
+           (unsigned long long)pc->cmd_words, (unsigned long long)pc->wdata_beats, (unsigned long long)pc->wr_words);
+    printf("  ACT: %llu, PRE: %llu, RD: %llu, WR: %llu, REF: %llu, ZQ: %llu\n",
+           (unsigned long long)pc->n_act, (unsigned long long)pc->n_pre, (unsigned long long)pc->n_rd,
+           (unsigned long long)pc->n_wr, (unsigned long long)pc->n_ref, (unsigned long long)pc->n_zq);
+    printf("  Read beats: %llu, RDATA overflows: %llu\n",
+           (unsigned long long)pc->rd_beats, (unsigned long long)pc->rdata_overflows);
+    printf("  Issue window: %llu nCK\n", (unsigned long long)perf_issue_nck(pc));
+}
+
 // Debug GPIO
 void debug_gpio() {
     uint32_t gpio_data = gpio_read(1, false);
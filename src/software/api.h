@@ -4,9 +4,187 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// Ranks
+// The rank bit [24] of the command word is carried through the encoders, the
+// decoder, ddr4_adapter and the model, but the PHY IP is generated
+// single-rank (C0.CS_WIDTH 1, cs_n[1] tied off in ddr4_interface.v), so only
+// rank 0 is usable. PRE/ACT, the row helpers and all_bank_refresh() reject
+// other ranks; column commands and REF always address rank 0. Raising this
+// needs the IP regenerated with CS_WIDTH 2, cs_n/cke/odt[1] wired, and
+// rank_addr on the column commands.
+#define MAX_RANKS 1
+
+// Command Buffer
+// Records encoded commands (and their NOP intervals) into host memory so that
+// a whole sequence can be submitted to the AXI bridge in one flush.
+typedef struct {
+    uint32_t *words;   // Encoded 32-bit command words
+    uint32_t n_words;  // Number of recorded words
+    uint32_t capacity; // Capacity in words (recording grows it as needed)
+    uint32_t nck;      // DRAM cycles (nCK) of the recorded (not yet flushed) commands
+    uint32_t n_sent;   // Words already accepted by cmd_buf_submit
+    uint8_t open_slots; // Strict slots of the 128-bit word still being packed
+    uint8_t open_wr;    // WR kinds in that word (CMD_BUF_WR_HOST/PATTERN)
+} cmd_buf_t;
+#define CMD_BUF_WR_HOST    (1 << 0)
+#define CMD_BUF_WR_PATTERN (1 << 1)
+
+// FIFO Credits (free entries, see fifo_credits)
+typedef struct {
+    uint32_t cmd;   // CMD FIFO: 128-bit command words (up to 4 slots each)
+} fifo_credits_t;
+
+// DMA Wait Mode
+typedef enum {
+    DMA_WAIT_POLL,   // Spin on the DMA status (default)
+    DMA_WAIT_IRQ,    // Sleep until the DMA interrupt
+    DMA_WAIT_HYBRID  // Spin briefly, then sleep until the DMA interrupt
+} dma_wait_mode_t;
+
+// Write Data Patterns (generated in fabric by pattern WRs)
+// See gen_pattern() in utils.c for the software reference.
+typedef enum {
+    PATTERN_HOST       = 0, // Host data (WDATA DMA)
+    PATTERN_FNV        = 1, // gen_data_pattern()
+    PATTERN_SOLID      = 2, // seed
+    PATTERN_CHECKER    = 3, // (row ^ i ^ j) & 1 ? ~seed : seed
+    PATTERN_ROW_STRIPE = 4  // row & 1 ? ~seed : seed
+} pattern_id_t;
+
+// Read Compare Summary (one batch of compare RDs)
+typedef struct {
+    uint32_t beats;      // Beats compared
+    uint32_t mismatches; // Beats with flipped bits
+    uint32_t flips;      // Flipped bits
+    uint32_t dropped;    // Mismatch records dropped in fabric (mask incomplete)
+} rd_compare_t;
+
+// Loop Engine Program
+// Instructions are recorded into host memory, uploaded to the IMEM once and
+// then run in fabric (see loop_engine.v for the instruction format).
+typedef struct {
+    uint64_t *instrs;  // Encoded 64-bit instructions
+    uint32_t n_instrs; // Number of recorded instructions
+    uint32_t capacity; // Capacity in instructions
+} prog_t;
+
+// Loop Engine Registers
+typedef enum {
+    PROG_REG_CNT0 = 0, // Loop counters
+    PROG_REG_CNT1 = 1,
+    PROG_REG_CNT2 = 2,
+    PROG_REG_CNT3 = 3,
+    PROG_REG_BANK = 4, // Bank counter
+    PROG_REG_ROW  = 5, // Row counter
+    PROG_REG_COL  = 6  // Column counter
+} prog_reg_t;
+
+// Counter Substitution (uses argument of the command instructions)
+#define PROG_USE_BANK (1 << 0) // Bank from PROG_REG_BANK
+#define PROG_USE_ROW  (1 << 1) // Row from PROG_REG_ROW (ACT)
+#define PROG_USE_COL  (1 << 2) // Column from PROG_REG_COL (RD/WR)
+
+// Performance Counters (fabric cycles and events since perf_clear)
+// The design has no AXI-Lite register bank, so perf_snapshot reads them one
+// 32-bit half at a time through the GPIO state word (perf view).
+typedef struct {
+    uint64_t cycles;             // Fabric cycles (4 DRAM cycles each)
+    uint64_t cmd_words;          // Command words accepted by the scheduler
+    uint64_t wdata_beats;        // Write data beats accepted
+    uint64_t issued_words;       // Command words issued to the DRAM
+    uint64_t wr_words;           // Issued words with a WR
+    uint64_t wdata_stall_cycles; // WR waiting for host write data (DMA-bound)
+    uint64_t wait_cycles;        // Idle cycles from WAIT commands (DRAM timing)
+    uint64_t cmd_empty_cycles;   // No command word to issue (host-bound)
+    uint64_t rdata_overflows;    // Read beats dropped at the full RDATA FIFO
+    uint64_t n_act;              // Issued commands by type
+    uint64_t n_pre;
+    uint64_t n_rd;
+    uint64_t n_wr;
+    uint64_t n_ref;
+    uint64_t n_zq;
+    uint64_t rd_beats;           // Read beats returned by the DRAM
+    uint64_t first_issue;        // DRAM cycle of the first non-NOP command of the issue window
+    uint64_t last_issue;         // DRAM cycle of the last non-NOP command of the issue window
+} perf_counters_t;
+
+// Refresh Modes (see refresh_config)
+typedef enum {
+    REFRESH_MANUAL, // all_bank_refresh() only
+    REFRESH_AUTO,   // tREFI scheduler in the row helpers (see refresh_config)
+    REFRESH_OFF     // No refresh (retention experiments)
+} refresh_mode_t;
+
+#define REFRESH_MAX_RANKS    MAX_RANKS
+#define REFRESH_MAX_POSTPONE 8 // REFs DDR4 allows to postpone
+// REFRESH_AUTO deadlines come from CLOCK_MONOTONIC and are serviced only
+// inside the row helpers and prog_start: a long command stream submitted
+// with cmd_buf_flush/cmd_buf_submit or a loop engine program gets no REFs
+// while it runs, so it must stay under (postpone + 1) * tREFI or carry its
+// own (cmd_buf_rf, prog_rf).
+
+// Refresh Statistics
+typedef struct {
+    uint64_t refs;   // REFs issued by the scheduler
+    uint64_t bursts; // PREA + REF bursts
+    uint64_t late;   // REFs issued past the postpone limit (retention window exceeded)
+} refresh_stats_t;
+
+// Row Pipeline Callbacks
+// Generate the data of a row (16*128 words) / check it, non-zero to stop.
+typedef void (*row_gen_fn_t)(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, void *arg);
+typedef int (*row_check_fn_t)(const uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, void *arg);
+
 int setup_hardware();
 void cleanup_hardware();
 
+void dma_send_start(void *dma_base, unsigned long phys_addr, uint32_t length_bytes);
+void dma_send_wait(void *dma_base);
+void dma_send(void *dma_base, unsigned long phys_addr, uint32_t length_bytes);
+void dma_recv_start(void *dma_base, unsigned long phys_addr, uint32_t length_bytes);
+void dma_recv_wait(void *dma_base);
+void dma_recv(void *dma_base, unsigned long phys_addr, uint32_t length_bytes);
+int dma_set_wait_mode(dma_wait_mode_t mode, uint32_t spin_iters);
+int dma_irq_eventfd(int efd);
+int bridge_config(uint32_t store_bits);
+void bridge_flush();
+
+// DMA Queue
+// Row-sized udmabuf slots per direction. With the scatter-gather engine each
+// slot owns a descriptor of a ring, so queued transfers run back to back.
+uint32_t dma_queue_slots();
+uint32_t *dma_send_slot();
+void dma_send_queue(uint32_t length_bytes);
+uint32_t dma_send_reap();
+void dma_send_drain();
+void dma_recv_queue(uint32_t length_bytes);
+uint32_t *dma_recv_complete();
+void dma_recv_release();
+uint32_t dma_recv_pending();
+void dma_recv_drain();
+
+int cmd_buf_init(cmd_buf_t *cb, uint32_t capacity);
+void cmd_buf_free(cmd_buf_t *cb);
+void cmd_buf_reset(cmd_buf_t *cb);
+uint32_t cmd_buf_flush(cmd_buf_t *cb);
+uint32_t cmd_buf_submit(cmd_buf_t *cb);
+
+uint32_t cmd_buf_nop(cmd_buf_t *cb, uint32_t interval, bool strict);
+uint32_t cmd_buf_pre(cmd_buf_t *cb, uint8_t bank_addr, uint8_t rank_addr, bool bank_all, uint32_t interval, bool strict);
+uint32_t cmd_buf_act(cmd_buf_t *cb, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, uint32_t interval, bool strict);
+uint32_t cmd_buf_rd(cmd_buf_t *cb, uint8_t bank_addr, uint16_t col_addr, uint32_t interval, bool strict);
+uint32_t cmd_buf_rd_batch(cmd_buf_t *cb, uint8_t bank_addr, uint16_t col_addr, bool last, uint32_t interval, bool strict);
+uint32_t cmd_buf_rd_compare(cmd_buf_t *cb, uint8_t bank_addr, uint16_t col_addr, uint8_t pattern_id, bool last, uint32_t interval, bool strict);
+uint32_t cmd_buf_wr(cmd_buf_t *cb, uint8_t bank_addr, uint16_t col_addr, uint32_t interval, bool strict);
+uint32_t cmd_buf_wr_pattern(cmd_buf_t *cb, uint8_t bank_addr, uint16_t col_addr, uint8_t pattern_id, uint32_t interval, bool strict);
+uint32_t cmd_buf_cfg(cmd_buf_t *cb, uint8_t reg_addr, uint16_t value, uint32_t interval, bool strict);
+uint32_t cmd_buf_pattern_seed(cmd_buf_t *cb, uint32_t seed);
+uint32_t cmd_buf_issue_mark(cmd_buf_t *cb);
+uint32_t cmd_buf_rf(cmd_buf_t *cb, uint32_t interval, bool strict);
+
+// Commands and row helpers return the DRAM cycles (nCK) they add to the
+// command stream: 4 per 128-bit command word and per WAIT cycle.
+uint32_t nop(uint32_t interval, bool strict);
 uint32_t pre(uint8_t bank_addr, uint8_t rank_addr, bool bank_all, uint32_t interval, bool strict);
 uint32_t act(uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, uint32_t interval, bool strict);
 uint32_t rd(uint32_t *buffer, uint8_t bank_addr, uint16_t col_addr, uint32_t interval, bool strict);
@@ -14,10 +192,48 @@ uint32_t wr(uint32_t *buffer, uint8_t bank_addr, uint16_t col_addr, uint32_t int
 uint32_t rf(uint32_t interval, bool strict);
 
 uint32_t write_row(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr);
+uint32_t write_row_pattern(uint8_t pattern_id, uint32_t seed, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr);
 uint32_t write_row_batch(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr);
 uint32_t read_row(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr);
 uint32_t read_row_batch(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr);
+uint32_t read_row_compare(uint8_t pattern_id, uint32_t seed, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, rd_compare_t *result, uint32_t *mask_buf);
+uint32_t write_row_queue(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr);
+uint32_t read_row_queue(uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr);
+void read_row_complete(uint32_t *data_buf);
+uint32_t write_rows_interleaved(uint32_t *data_buf, const uint8_t *bank_addrs, uint8_t n_banks, uint32_t row_addr, uint8_t rank_addr);
+uint32_t write_rows_interleaved_pattern(uint8_t pattern_id, uint32_t seed, const uint8_t *bank_addrs, uint8_t n_banks, uint32_t row_addr, uint8_t rank_addr);
+uint32_t read_rows_interleaved(uint32_t *data_buf, const uint8_t *bank_addrs, uint8_t n_banks, uint32_t row_addr, uint8_t rank_addr);
+uint32_t write_rows_pipelined(uint8_t n_ranks, uint8_t n_banks, uint32_t n_rows, uint32_t depth, bool refresh, row_gen_fn_t gen, void *arg);
+int read_rows_pipelined(uint8_t n_ranks, uint8_t n_banks, uint32_t n_rows, uint32_t depth, bool refresh, row_check_fn_t check, void *arg);
 uint32_t all_bank_refresh(uint8_t rank_addr);
+int refresh_config(refresh_mode_t mode, uint8_t n_ranks, uint32_t postpone);
+void refresh_stats(refresh_stats_t *st);
+
+int prog_init(prog_t *pg, uint32_t capacity);
+void prog_free(prog_t *pg);
+void prog_reset(prog_t *pg);
+uint32_t prog_nop(prog_t *pg, uint32_t interval);
+uint32_t prog_pre(prog_t *pg, uint8_t bank_addr, uint8_t rank_addr, bool bank_all, uint32_t interval, uint8_t uses);
+uint32_t prog_act(prog_t *pg, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, uint32_t interval, uint8_t uses);
+uint32_t prog_rd(prog_t *pg, uint8_t bank_addr, uint16_t col_addr, uint8_t pattern_id, bool last, uint32_t interval, uint8_t uses);
+uint32_t prog_wr(prog_t *pg, uint8_t bank_addr, uint16_t col_addr, uint8_t pattern_id, uint32_t interval, uint8_t uses);
+uint32_t prog_rf(prog_t *pg, uint32_t interval);
+uint32_t prog_set(prog_t *pg, prog_reg_t reg, uint32_t value);
+uint32_t prog_add(prog_t *pg, prog_reg_t reg, uint32_t value);
+uint32_t prog_loop(prog_t *pg, prog_reg_t counter, uint32_t target);
+uint32_t prog_jump(prog_t *pg, uint32_t target);
+uint32_t prog_halt(prog_t *pg);
+void prog_upload(const prog_t *pg, uint32_t imem_addr);
+void prog_start(uint32_t imem_addr);
+void prog_wait();
+
+void perf_clear();
+void perf_snapshot(perf_counters_t *pc);
+void perf_print(const perf_counters_t *pc);
+uint64_t perf_issue_nck(const perf_counters_t *pc);
+void issue_mark();
+void cmd_drain();
+void fifo_credits(fifo_credits_t *fc);
 
 void debug_gpio();
 
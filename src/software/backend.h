@@ -0,0 +1,138 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Backend
+// Everything api.c does to the device goes through one of these: the MMIO
+// hardware backend (ZCU104) or the in-process DDR4 model (ddr4_model.c).
+// setup maps (or allocates) the DMA/bridge/GPIO register windows and the
+// udmabuf and fills in the globals below. The DMA and GPIO registers are
+// accessed with mmio_read/mmio_write at the mapped addresses; command words
+// go to the AXI bridge with bridge_write; bridge_flush pushes out stores the
+// backend still holds (write combining) and must run before register accesses
+// that depend on them.
+typedef struct {
+    const char *name;
+    int (*setup)(void);
+    void (*cleanup)(void);
+    uint32_t (*mmio_read)(volatile void *addr);
+    void (*mmio_write)(volatile void *addr, uint32_t value);
+    void (*bridge_write)(const uint32_t *words, uint32_t n_words);
+    void (*bridge_flush)(void);
+} backend_t;
+
+extern const backend_t hw_backend;
+extern const backend_t model_backend;
+
+// Select the backend used by setup_hardware (before it is called)
+// Without a call, SDDT_BACKEND=model in the environment selects the model.
+void set_backend(const backend_t *b);
+
+// Mappings (set up by the backend)
+extern void *dma0_vptr;
+extern void *bridge_vptr;
+extern void *gpio_vptr;
+extern void *udmabuf_vptr;
+extern unsigned int udmabuf_size;
+extern unsigned long udmabuf_phys_addr;
+
+// DMA Register Offsets
+#define MM2S_DMACR      0x00 // Control
+#define MM2S_DMASR      0x04 // Status
+#define MM2S_SA         0x18 // Source Address
+#define MM2S_SA_MSB     0x1C // 32bit addressing
+#define MM2S_LENGTH     0x28 // Length of the transfer
+#define S2MM_DMACR      0x30 // Control
+#define S2MM_DMASR      0x34 // Status
+#define S2MM_DA         0x48 // Destination Address
+#define S2MM_DA_MSB     0x4C // 32bit addressing
+#define S2MM_LENGTH     0x58 // Length of the transfer
+
+// DMA Scatter-Gather Register Offsets
+#define MM2S_CURDESC      0x08 // Current Descriptor Pointer
+#define MM2S_CURDESC_MSB  0x0C // 32bit addressing
+#define MM2S_TAILDESC     0x10 // Tail Descriptor Pointer (starts fetching)
+#define MM2S_TAILDESC_MSB 0x14 // 32bit addressing
+#define S2MM_CURDESC      0x38 // Current Descriptor Pointer
+#define S2MM_CURDESC_MSB  0x3C // 32bit addressing
+#define S2MM_TAILDESC     0x40 // Tail Descriptor Pointer (starts fetching)
+#define S2MM_TAILDESC_MSB 0x44 // 32bit addressing
+
+// DMA Control/Status Bits
+#define DMACR_RS        (1 << 0)  // Run/Stop
+#define DMACR_RESET     (1 << 2)  // Soft reset (both channels)
+#define DMACR_IOC_IRQ   (1 << 12) // Interrupt on complete enable
+#define DMACR_ERR_IRQ   (1 << 14) // Interrupt on error enable
+#define DMASR_HALTED    (1 << 0)  // Halted (Run/Stop is 0)
+#define DMASR_IDLE      (1 << 1)  // Idle
+#define DMASR_SG_INCLD  (1 << 3)  // Scatter-Gather engine included
+
+// DMA Scatter-Gather Descriptor
+#define SG_DESC_SIZE            0x40 // Descriptors must be 64-byte aligned
+#define SG_DESC_NXTDESC         0x00 // Next Descriptor Pointer
+#define SG_DESC_NXTDESC_MSB     0x04 // 32bit addressing
+#define SG_DESC_BUFFER_ADDR     0x08 // Buffer Address
+#define SG_DESC_BUFFER_ADDR_MSB 0x0C // 32bit addressing
+#define SG_DESC_CONTROL         0x18 // [25:0] buffer length
+#define SG_DESC_STATUS          0x1C // Written back by the DMA
+#define SG_CTRL_TXSOF           (1 << 27) // MM2S start of frame
+#define SG_CTRL_TXEOF           (1 << 26) // MM2S end of frame
+#define SG_STS_CMPLT            (1u << 31) // Completed
+#define SG_STS_RXEOF            (1 << 26) // S2MM end of frame (TLAST)
+#define SG_STS_ERR              (0x7 << 28) // DMA decode/slave/internal error
+
+// GPIO Register Offsets
+#define GPIO_DATA       0x00  // Channel 1 Data Register
+#define GPIO_TRI        0x04  // Channel 1 Tri-state Register (0=output, 1=input)
+#define GPIO2_DATA      0x08  // Channel 2 Data Register
+#define GPIO2_TRI       0x0C  // Channel 2 Tri-state Register (0=output, 1=input)
+
+// WAIT Command
+#define WAIT_MAX_COUNT 0x7FFFFFF // 27-bit idle cycle count ([29:3] of the command word)
+
+// Read Compare Records (rdata_comparator.v)
+#define CMP_REC_MISMATCH  1 // Header beat, followed by the XOR mask beat
+#define CMP_REC_SUMMARY   2 // Last beat of the batch
+#define CMP_MAX_BYTES     ((2 * 128 + 1) * 16 * sizeof(uint32_t)) // Every beat mismatched
+
+// CFG Registers (wdata_pattern_gen.v)
+#define CFG_SEED_LO 0 // Pattern seed [15:0]
+#define CFG_SEED_HI 1 // Pattern seed [31:16]
+#define CFG_IMEM_ADDR 2 // Loop engine IMEM write address (loop_engine.v)
+#define CFG_INSTR_0   3 // Instruction [15:0]
+#define CFG_INSTR_1   4 // Instruction [31:16]
+#define CFG_INSTR_2   5 // Instruction [47:32]
+#define CFG_INSTR_3   6 // Instruction [63:48], writes the instruction
+#define CFG_START     7 // Start the program at the value (IMEM address)
+#define CFG_ISSUE_MARK 8 // Restart the issue window (perf_counters.v)
+
+// Loop Engine (loop_engine.v)
+#define IMEM_DEPTH      2048 // 1 << IMEM_ADDR_WIDTH
+#define OP_HALT         0ull
+#define OP_CMD          1ull
+#define OP_SET          2ull
+#define OP_ADD          3ull
+#define OP_LOOP         4ull
+#define OP_JUMP         5ull
+#define PROG_WAIT_MAX   0x1FFFFFF // 25-bit WAIT count of a CMD instruction
+#define STATE_PROG_RUNNING (1u << 31) // GPIO state: program running
+#define STATE_PROG_DONE    (1u << 30) // GPIO state: toggles when a program halts
+#define STATE_PIPE_BUSY    (1u << 29) // GPIO state: command words held past the CMD FIFO
+
+// Performance Counters (perf_counters.v, GPIO control/state window)
+#define CTRL_DEBUG_VIEW    (1u << 31) // State shows the scheduler debug word
+#define CTRL_PERF_VIEW     (1u << 30) // State shows the selected counter half
+#define CTRL_PERF_SNAPSHOT (1u << 29) // Rising edge: copy counters to shadows
+#define CTRL_PERF_CLEAR    (1u << 28) // Rising edge: reset counters
+#define CTRL_PERF_INDEX(n) ((uint32_t)(n) << 2) // Counter * 2 + high half
+#define PERF_COUNTERS      18 // 16 event counters + first/last issue
+#define STATE_CMD_FIFO(s)  (((s) >> 16) & 0xFF) // GPIO state: CMD FIFO count
+#define STATE_WDATA_FIFO(s) (((s) >> 8) & 0xFF) // GPIO state: WDATA FIFO count
+#define STATE_RDATA_FIFO(s) ((s) & 0xFF)        // GPIO state: RDATA FIFO count
+
+// FIFO Depths (sddt_core.v)
+#define CMD_FIFO_DEPTH    16 // 128-bit command words
+
+#endif
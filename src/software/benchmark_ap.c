@@ -5,8 +5,9 @@
 #include <time.h>
 
 #include "api.h"
+#include "timing.h"
 
-int main(int argc, char *argv[]) {
+int main(void) {
     // Initialize hardware
     if (setup_hardware() != 0) return -1;
     printf("Hardware mapped successfully.\n");
@@ -18,6 +19,7 @@ int main(int argc, char *argv[]) {
     /*** Start operations ***/
     printf("Starting operations...\n");
     struct timespec start, end;
+    issue_mark();
     clock_gettime(CLOCK_MONOTONIC, &start);
 
     // Operations
@@ -25,8 +27,8 @@ int main(int argc, char *argv[]) {
     for (uint8_t rank_addr = 0; rank_addr < n_ranks; rank_addr++) {
         for (uint8_t bank_addr = 0; bank_addr < n_banks; bank_addr++) {
             for (uint32_t row_addr = 0; row_addr < n_rows; row_addr++) {
-                nck += pre(bank_addr, rank_addr, false, 9, false);
-                nck += act(bank_addr, row_addr, rank_addr, 9, false);
+                nck += pre(bank_addr, rank_addr, false, timing.tRP, false);
+                nck += act(bank_addr, row_addr, rank_addr, timing.tRCD, false);
             }
         }
     }
@@ -37,10 +39,17 @@ int main(int argc, char *argv[]) {
 
     double latency_s = (end.tv_sec - start.tv_sec) + 
                         (end.tv_nsec - start.tv_nsec) * 1e-9;
-    double ideal_latency_s = nck * 1.5e-9;
+    double ideal_latency_s = nck * timing.tCK * 1e-9;
     printf("Time taken: %f seconds\n", latency_s);
     printf("Overhead: %fx slower than ideal\n", latency_s / ideal_latency_s);
 
+    // DRAM-side issue density (hardware issue window)
+    perf_counters_t perf;
+    cmd_drain();
+    perf_snapshot(&perf);
+    uint64_t issued_nck = perf_issue_nck(&perf);
+    printf("Issued over %llu nCK: %fx the ideal %u nCK\n", (unsigned long long)issued_nck, (double)issued_nck / nck, nck);
+
     // Cleanup
     cleanup_hardware();
 
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api.h"
+#include "timing.h"
+#include "utils.h"
+
+// Issue window since the last issue_mark()
+static uint64_t issued_nck(void) {
+    perf_counters_t perf;
+    cmd_drain();
+    perf_snapshot(&perf);
+    return perf_issue_nck(&perf);
+}
+
+int main(int argc, char *argv[]) {
+    // Bank groups alternate: 0, 4, 8, 12, 1, 5, ...
+    uint8_t n_banks = 16;
+    uint8_t banks[16];
+    for (uint8_t b = 0; b < n_banks; b++) banks[b] = (b % 4) * 4 + b / 4;
+    uint32_t n_rows = 8;
+    uint8_t rank_addr = 0;
+    uint32_t seed = argc > 1 ? strtol(argv[1], NULL, 16) : 0x12345678;
+
+    uint32_t *write_data_buf = malloc(n_banks * 16 * 128 * sizeof(uint32_t));
+    uint32_t *read_data_buf = malloc(n_banks * 16 * 128 * sizeof(uint32_t));
+    if (!write_data_buf || !read_data_buf) return -1;
+
+    // Initialize hardware
+    if (setup_hardware() != 0) return -1;
+    printf("Hardware mapped successfully.\n");
+
+    // One bank at a time
+    issue_mark();
+    for (uint32_t row_addr = 0; row_addr < n_rows; row_addr++) {
+        for (uint8_t b = 0; b < n_banks; b++) {
+            gen_data_pattern(write_data_buf, banks[b], row_addr, rank_addr, seed);
+            write_row_batch(write_data_buf, banks[b], row_addr, rank_addr);
+        }
+    }
+    uint64_t nck_row = issued_nck();
+
+    // Bank groups interleaved
+    issue_mark();
+    for (uint32_t row_addr = 0; row_addr < n_rows; row_addr++) {
+        for (uint8_t b = 0; b < n_banks; b++) {
+            gen_data_pattern(write_data_buf + b * 16 * 128, banks[b], row_addr, rank_addr, seed);
+        }
+        write_rows_interleaved(write_data_buf, banks, n_banks, row_addr, rank_addr);
+    }
+    uint64_t nck_ilv = issued_nck();
+
+    // Read back and verify
+    issue_mark();
+    uint32_t errors = 0;
+    for (uint32_t row_addr = 0; row_addr < n_rows; row_addr++) {
+        read_rows_interleaved(read_data_buf, banks, n_banks, row_addr, rank_addr);
+        for (uint8_t b = 0; b < n_banks; b++) {
+            gen_data_pattern(write_data_buf, banks[b], row_addr, rank_addr, seed);
+            if (memcmp(write_data_buf, read_data_buf + b * 16 * 128, 16 * 128 * sizeof(uint32_t)) != 0) errors++;
+        }
+    }
+    uint64_t nck_rd = issued_nck();
+
+    // Pattern initialization
+    issue_mark();
+    for (uint32_t row_addr = 0; row_addr < n_rows; row_addr++) {
+        write_rows_interleaved_pattern(PATTERN_FNV, seed, banks, n_banks, row_addr, rank_addr);
+    }
+    uint64_t nck_pat = issued_nck();
+
+    // Data bus busy time: 4 nCK per column command. The DDR4 model does not
+    // charge host time, so the read figure is an upper bound there (RDs wait
+    // for the RDATA FIFO to drain every READ_GROUP_COLS).
+    uint64_t bus_nck = (uint64_t)n_rows * n_banks * 128 * 4;
+    printf("Rows: %u x %u banks\n", n_rows, n_banks);
+    printf("write_row_batch:                %llu nCK (bus %.1f%%)\n", (unsigned long long)nck_row, 100.0 * bus_nck / nck_row);
+    printf("write_rows_interleaved:         %llu nCK (bus %.1f%%)\n", (unsigned long long)nck_ilv, 100.0 * bus_nck / nck_ilv);
+    printf("read_rows_interleaved:          %llu nCK (bus %.1f%%), %u rows mismatched\n", (unsigned long long)nck_rd, 100.0 * bus_nck / nck_rd, errors);
+    printf("write_rows_interleaved_pattern: %llu nCK (bus %.1f%%)\n", (unsigned long long)nck_pat, 100.0 * bus_nck / nck_pat);
+
+    // Cleanup
+    free(write_data_buf);
+    free(read_data_buf);
+    cleanup_hardware();
+
+    return errors ? -1 : 0;
+}
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "utils.h"
+
+// Elapsed Time (seconds)
+static double elapsed(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t scalar_buf[16*128];
+    uint32_t simd_buf[16*128];
+
+    uint32_t seed = (argc > 1) ? strtol(argv[1], NULL, 16) : 0x12345678;
+    uint8_t n_ranks = 1;
+    uint8_t n_banks = 16;
+    uint32_t n_rows = 4096;
+    double rows = (double)n_ranks * n_banks * n_rows;
+    double row_bytes = sizeof(scalar_buf);
+
+    // Bit-identical check
+    for (uint8_t rank_addr = 0; rank_addr < n_ranks; rank_addr++) {
+        for (uint8_t bank_addr = 0; bank_addr < n_banks; bank_addr++) {
+            for (uint32_t row_addr = 0; row_addr < n_rows; row_addr++) {
+                gen_data_pattern_scalar(scalar_buf, bank_addr, row_addr, rank_addr, seed);
+                gen_data_pattern(simd_buf, bank_addr, row_addr, rank_addr, seed);
+                if (memcmp(scalar_buf, simd_buf, sizeof(scalar_buf)) != 0) {
+                    printf("Error: Pattern mismatch at rank %u, bank %u, row %u\n", rank_addr, bank_addr, row_addr);
+                    return -1;
+                }
+            }
+        }
+    }
+    printf("Patterns match (%.0f rows).\n", rows);
+
+    // Scalar
+    struct timespec start, end;
+    uint32_t sink = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint8_t rank_addr = 0; rank_addr < n_ranks; rank_addr++) {
+        for (uint8_t bank_addr = 0; bank_addr < n_banks; bank_addr++) {
+            for (uint32_t row_addr = 0; row_addr < n_rows; row_addr++) {
+                gen_data_pattern_scalar(scalar_buf, bank_addr, row_addr, rank_addr, seed);
+                sink += scalar_buf[row_addr & 0x7FF];
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double scalar_time = elapsed(&start, &end);
+
+    // SIMD
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint8_t rank_addr = 0; rank_addr < n_ranks; rank_addr++) {
+        for (uint8_t bank_addr = 0; bank_addr < n_banks; bank_addr++) {
+            for (uint32_t row_addr = 0; row_addr < n_rows; row_addr++) {
+                gen_data_pattern(simd_buf, bank_addr, row_addr, rank_addr, seed);
+                sink += simd_buf[row_addr & 0x7FF];
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double simd_time = elapsed(&start, &end);
+
+    printf("Scalar: %f seconds, %.1f ns/row, %.1f MB/s\n", scalar_time, scalar_time / rows * 1e9, rows * row_bytes / scalar_time / 1e6);
+    printf("SIMD:   %f seconds, %.1f ns/row, %.1f MB/s\n", simd_time, simd_time / rows * 1e9, rows * row_bytes / simd_time / 1e6);
+    printf("Speedup: %.2fx (checksum %08x)\n", scalar_time / simd_time, sink);
+
+    // Compare kernel: injected flips must be reported exactly
+    flip_t flips[64];
+    gen_data_pattern(scalar_buf, 0, 0, 0, seed);
+    memcpy(simd_buf, scalar_buf, sizeof(simd_buf));
+    simd_buf[5] ^= 1u << 3;
+    simd_buf[2047] ^= 1u << 31;
+    uint32_t n_flips = compare_row(scalar_buf, simd_buf, flips, 64);
+    if (n_flips != 2 || flips[0].word != 5 || flips[0].bit != 3 || flips[0].dir != ((simd_buf[5] >> 3) & 1) ||
+        flips[1].word != 2047 || flips[1].bit != 31 || flips[1].dir != (simd_buf[2047] >> 31)) {
+        printf("Error: Compare kernel reported %u flips\n", n_flips);
+        return -1;
+    }
+    memcpy(simd_buf, scalar_buf, sizeof(simd_buf));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t k = 0; k < rows; k++) {
+        n_flips += compare_row(scalar_buf, simd_buf, flips, 64);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double compare_time = elapsed(&start, &end);
+    printf("Compare: %f seconds, %.1f ns/row, %.1f MB/s (flips %u)\n", compare_time, compare_time / rows * 1e9, rows * row_bytes / compare_time / 1e6, n_flips);
+
+    return 0;
+}
@@ -0,0 +1,403 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "api.h"
+#include "timing.h"
+#include "utils.h"
+
+// Benchmark Suite
+// Runs host-stack workloads one after another and reports, per workload,
+// the host latency of each operation (percentiles), the commands and bytes
+// issued to the DRAM per second of wall time, and the ideal and issued DRAM
+// cycles. Operation i of a workload targets row i of the (rank, bank, row)
+// space, rank by rank, bank by bank, row by row. Refresh stays manual unless
+// -R is given, so only the refresh workloads issue REFs.
+
+#define ROW_BYTES    (16 * 128 * sizeof(uint32_t))
+#define REFRESH_STORM REFRESH_MAX_POSTPONE // REFs per rank and storm
+#define SUBMIT_BUF_WORDS 1024 // One pattern row fill (seed CFG + PRE + ACT + 128 WRs and WAITs)
+
+typedef enum { FORMAT_TEXT, FORMAT_JSON, FORMAT_CSV } format_t;
+
+// Benchmark Configuration
+typedef struct {
+    uint8_t n_ranks;
+    uint8_t n_banks;
+    uint32_t n_rows;
+    uint32_t iterations; // Measured operations per workload
+    uint32_t warmup;     // Unmeasured operations before them
+    uint32_t seed;
+    bool refresh;        // REFRESH_AUTO during the workloads
+    uint32_t *data_buf;
+    cmd_buf_t submit_cb; // pattern_submit command buffer
+    uint64_t submit_gens; // Rows generated while out of CMD FIFO credits
+} bench_cfg_t;
+
+// Workload (one operation per call, returns its ideal DRAM cycles)
+typedef struct {
+    const char *name;
+    uint32_t (*op)(bench_cfg_t *cfg, uint32_t i);
+    bool writes;         // Row data is generated before the operation (not timed)
+} workload_t;
+
+// Workload Result
+typedef struct {
+    const char *name;
+    uint32_t ops;
+    double lat_min, lat_mean, lat_p50, lat_p90, lat_p99, lat_p999, lat_max; // ns
+    double wall_s;
+    uint64_t commands;   // Issued ACT/PRE/RD/WR/REF/ZQ
+    uint64_t bytes;      // Issued RD/WR data (64 bytes each)
+    uint64_t ideal_nck;
+    uint64_t issue_nck;
+} bench_result_t;
+
+// Row Address of the i-th operation
+static void op_addr(const bench_cfg_t *cfg, uint32_t i, uint8_t *rank_addr, uint8_t *bank_addr, uint32_t *row_addr) {
+    uint32_t n = i % (cfg->n_ranks * cfg->n_banks * cfg->n_rows);
+    *row_addr = n % cfg->n_rows;
+    *bank_addr = (n / cfg->n_rows) % cfg->n_banks;
+    *rank_addr = n / (cfg->n_rows * cfg->n_banks);
+}
+
+// PRE + ACT
+static uint32_t op_pre_act(bench_cfg_t *cfg, uint32_t i) {
+    uint8_t rank_addr, bank_addr;
+    uint32_t row_addr;
+    op_addr(cfg, i, &rank_addr, &bank_addr, &row_addr);
+    uint32_t nck = pre(bank_addr, rank_addr, false, timing.tRP, false);
+    nck += act(bank_addr, row_addr, rank_addr, timing.tRCD, false);
+    return nck;
+}
+
+static uint32_t op_write_row(bench_cfg_t *cfg, uint32_t i) {
+    uint8_t rank_addr, bank_addr;
+    uint32_t row_addr;
+    op_addr(cfg, i, &rank_addr, &bank_addr, &row_addr);
+    return write_row(cfg->data_buf, bank_addr, row_addr, rank_addr);
+}
+
+static uint32_t op_write_row_batch(bench_cfg_t *cfg, uint32_t i) {
+    uint8_t rank_addr, bank_addr;
+    uint32_t row_addr;
+    op_addr(cfg, i, &rank_addr, &bank_addr, &row_addr);
+    return write_row_batch(cfg->data_buf, bank_addr, row_addr, rank_addr);
+}
+
+static uint32_t op_read_row(bench_cfg_t *cfg, uint32_t i) {
+    uint8_t rank_addr, bank_addr;
+    uint32_t row_addr;
+    op_addr(cfg, i, &rank_addr, &bank_addr, &row_addr);
+    return read_row(cfg->data_buf, bank_addr, row_addr, rank_addr);
+}
+
+static uint32_t op_read_row_batch(bench_cfg_t *cfg, uint32_t i) {
+    uint8_t rank_addr, bank_addr;
+    uint32_t row_addr;
+    op_addr(cfg, i, &rank_addr, &bank_addr, &row_addr);
+    return read_row_batch(cfg->data_buf, bank_addr, row_addr, rank_addr);
+}
+
+// Pattern Row Fill (non-blocking submit)
+// While the CMD FIFO has no credits the host generates row data instead of
+// stalling in a bridge store (stands in for pattern generation/verification).
+static uint32_t op_pattern_submit(bench_cfg_t *cfg, uint32_t i) {
+    uint8_t rank_addr, bank_addr;
+    uint32_t row_addr;
+    op_addr(cfg, i, &rank_addr, &bank_addr, &row_addr);
+    cmd_buf_t *cb = &cfg->submit_cb;
+    cmd_buf_pattern_seed(cb, cfg->seed);
+    cmd_buf_pre(cb, bank_addr, rank_addr, false, timing.tRP, false);
+    cmd_buf_act(cb, bank_addr, row_addr, rank_addr, timing.tRCD, false);
+    for (uint32_t col = 0; col < 128; col++) {
+        cmd_buf_wr_pattern(cb, bank_addr, col * 8, PATTERN_FNV, timing.tCCD_L, false);
+    }
+    uint32_t nck = cb->nck;
+    while (cb->n_words > 0) {
+        if (cmd_buf_submit(cb) == 0) {
+            gen_data_pattern(cfg->data_buf, bank_addr, row_addr, rank_addr, cfg->seed);
+            cfg->submit_gens++;
+        }
+    }
+    return nck;
+}
+
+// Refresh Storm (REFRESH_STORM all-bank refreshes per rank)
+static uint32_t op_refresh(bench_cfg_t *cfg, uint32_t i) {
+    (void)i; // Every operation is the same storm
+    uint32_t nck = 0;
+    for (uint8_t rank_addr = 0; rank_addr < cfg->n_ranks; rank_addr++) {
+        for (uint32_t n = 0; n < REFRESH_STORM; n++) {
+            nck += all_bank_refresh(rank_addr);
+        }
+    }
+    return nck;
+}
+
+// Mixed (three batched row reads per batched row write, a refresh of
+// every rank each 16 operations)
+static uint32_t op_mixed(bench_cfg_t *cfg, uint32_t i) {
+    uint32_t nck = (i % 4 == 3) ? op_write_row_batch(cfg, i) : op_read_row_batch(cfg, i);
+    if (i % 16 == 15) {
+        for (uint8_t rank_addr = 0; rank_addr < cfg->n_ranks; rank_addr++) {
+            nck += all_bank_refresh(rank_addr);
+        }
+    }
+    return nck;
+}
+
+static const workload_t workloads[] = {
+    { "pre_act",         op_pre_act,         false },
+    { "write_row",       op_write_row,       true  },
+    { "write_row_batch", op_write_row_batch, true  },
+    { "read_row",        op_read_row,        false },
+    { "read_row_batch",  op_read_row_batch,  false },
+    { "pattern_submit",  op_pattern_submit,  false },
+    { "refresh",         op_refresh,         false },
+    { "mixed",           op_mixed,           true  },
+};
+#define N_WORKLOADS (sizeof(workloads) / sizeof(workloads[0]))
+
+// Elapsed Time (nanoseconds)
+static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Percentile of sorted samples (nearest rank)
+static double percentile(const double *sorted, uint32_t n, double p) {
+    uint32_t k = (uint32_t)ceil(p / 100.0 * n);
+    return sorted[k > 0 ? k - 1 : 0];
+}
+
+// Workload Run
+static int bench_run(bench_cfg_t *cfg, const workload_t *w, double *lat, bench_result_t *res) {
+    memset(res, 0, sizeof(*res));
+    res->name = w->name;
+    res->ops = cfg->iterations;
+    if (refresh_config(cfg->refresh ? REFRESH_AUTO : REFRESH_MANUAL, cfg->n_ranks, REFRESH_MAX_POSTPONE) != 0) return -1;
+    for (uint32_t i = 0; i < cfg->warmup; i++) {
+        w->op(cfg, i);
+    }
+    cmd_drain();
+
+    struct timespec start, end, t0, t1;
+    perf_counters_t perf;
+    perf_clear();
+    issue_mark();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < cfg->iterations; i++) {
+        uint8_t rank_addr, bank_addr;
+        uint32_t row_addr;
+        if (w->writes) {
+            op_addr(cfg, i, &rank_addr, &bank_addr, &row_addr);
+            gen_data_pattern(cfg->data_buf, bank_addr, row_addr, rank_addr, cfg->seed);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        res->ideal_nck += w->op(cfg, i);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        lat[i] = elapsed_ns(&t0, &t1);
+    }
+    cmd_drain();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    perf_snapshot(&perf);
+
+    res->wall_s = elapsed_ns(&start, &end) * 1e-9;
+    res->commands = perf.n_act + perf.n_pre + perf.n_rd + perf.n_wr + perf.n_ref + perf.n_zq;
+    res->bytes = (perf.n_rd + perf.n_wr) * 64;
+    res->issue_nck = perf_issue_nck(&perf);
+
+    double sum = 0;
+    for (uint32_t i = 0; i < cfg->iterations; i++) sum += lat[i];
+    qsort(lat, cfg->iterations, sizeof(double), cmp_double);
+    res->lat_min = lat[0];
+    res->lat_mean = sum / cfg->iterations;
+    res->lat_p50 = percentile(lat, cfg->iterations, 50);
+    res->lat_p90 = percentile(lat, cfg->iterations, 90);
+    res->lat_p99 = percentile(lat, cfg->iterations, 99);
+    res->lat_p999 = percentile(lat, cfg->iterations, 99.9);
+    res->lat_max = lat[cfg->iterations - 1];
+    return 0;
+}
+
+// Result Output
+static void print_header(FILE *out, format_t format, const bench_cfg_t *cfg) {
+    switch (format) {
+        case FORMAT_TEXT:
+            fprintf(out, "Profile %s (tCK %.3f ns), %u ranks x %u banks x %u rows, %u iterations (%u warmup), refresh %s\n",
+                    timing.name, timing.tCK, cfg->n_ranks, cfg->n_banks, cfg->n_rows, cfg->iterations, cfg->warmup,
+                    cfg->refresh ? "auto" : "manual");
+            fprintf(out, "%-16s %10s %10s %10s %10s %10s %10s %14s %12s %10s %10s\n",
+                    "workload", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "max ns", "mean ns", "commands/s", "MB/s", "ideal nCK", "issue nCK");
+            break;
+        case FORMAT_JSON:
+            fprintf(out, "{\n  \"profile\": \"%s\",\n  \"tCK_ns\": %.3f,\n  \"ranks\": %u,\n  \"banks\": %u,\n  \"rows\": %u,\n"
+                    "  \"iterations\": %u,\n  \"warmup\": %u,\n  \"refresh\": \"%s\",\n  \"workloads\": [",
+                    timing.name, timing.tCK, cfg->n_ranks, cfg->n_banks, cfg->n_rows, cfg->iterations, cfg->warmup,
+                    cfg->refresh ? "auto" : "manual");
+            break;
+        case FORMAT_CSV:
+            fprintf(out, "workload,ops,lat_min_ns,lat_mean_ns,lat_p50_ns,lat_p90_ns,lat_p99_ns,lat_p999_ns,lat_max_ns,"
+                    "wall_s,commands,commands_per_s,bytes,bytes_per_s,ideal_nck,issue_nck\n");
+            break;
+    }
+}
+
+static void print_result(FILE *out, format_t format, const bench_result_t *r, bool first) {
+    double cmd_rate = r->commands / r->wall_s;
+    double byte_rate = r->bytes / r->wall_s;
+    switch (format) {
+        case FORMAT_TEXT:
+            fprintf(out, "%-16s %10.0f %10.0f %10.0f %10.0f %10.0f %10.0f %14.0f %12.1f %10llu %10llu\n",
+                    r->name, r->lat_p50, r->lat_p90, r->lat_p99, r->lat_p999, r->lat_max, r->lat_mean,
+                    cmd_rate, byte_rate / 1e6, (unsigned long long)r->ideal_nck, (unsigned long long)r->issue_nck);
+            break;
+        case FORMAT_JSON:
+            fprintf(out, "%s\n    {\"name\": \"%s\", \"ops\": %u, \"latency_ns\": {\"min\": %.0f, \"mean\": %.1f, \"p50\": %.0f, "
+                    "\"p90\": %.0f, \"p99\": %.0f, \"p999\": %.0f, \"max\": %.0f}, \"wall_s\": %.6f, \"commands\": %llu, "
+                    "\"commands_per_s\": %.1f, \"bytes\": %llu, \"bytes_per_s\": %.1f, \"ideal_nck\": %llu, \"issue_nck\": %llu}",
+                    first ? "" : ",", r->name, r->ops, r->lat_min, r->lat_mean, r->lat_p50, r->lat_p90, r->lat_p99, r->lat_p999,
+                    r->lat_max, r->wall_s, (unsigned long long)r->commands, cmd_rate, (unsigned long long)r->bytes, byte_rate,
+                    (unsigned long long)r->ideal_nck, (unsigned long long)r->issue_nck);
+            break;
+        case FORMAT_CSV:
+            fprintf(out, "%s,%u,%.0f,%.1f,%.0f,%.0f,%.0f,%.0f,%.0f,%.6f,%llu,%.1f,%llu,%.1f,%llu,%llu\n",
+                    r->name, r->ops, r->lat_min, r->lat_mean, r->lat_p50, r->lat_p90, r->lat_p99, r->lat_p999, r->lat_max,
+                    r->wall_s, (unsigned long long)r->commands, cmd_rate, (unsigned long long)r->bytes, byte_rate,
+                    (unsigned long long)r->ideal_nck, (unsigned long long)r->issue_nck);
+            break;
+    }
+}
+
+static void print_footer(FILE *out, format_t format) {
+    if (format == FORMAT_JSON) fprintf(out, "\n  ]\n}\n");
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [-w workload,...] [-n iterations] [-W warmup] [-k ranks] [-b banks] [-r rows]\n"
+           "          [-s seed] [-R] [-f text|json|csv] [-o file]\n", prog);
+    printf("Workloads:");
+    for (uint32_t i = 0; i < N_WORKLOADS; i++) printf(" %s", workloads[i].name);
+    printf(" (default: all)\n");
+}
+
+// Workload Selection (comma separated names, "all")
+static int parse_workloads(char *list, bool *selected) {
+    for (char *name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+        bool found = false;
+        for (uint32_t i = 0; i < N_WORKLOADS; i++) {
+            if (strcmp(name, "all") == 0 || strcmp(name, workloads[i].name) == 0) {
+                selected[i] = true;
+                found = true;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "Unknown workload: %s\n", name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    bench_cfg_t cfg = { .n_ranks = 1, .n_banks = 16, .n_rows = 64, .iterations = 1024, .warmup = 16, .seed = 0x12345678 };
+    bool selected[N_WORKLOADS] = { false };
+    format_t format = FORMAT_TEXT;
+    const char *out_path = NULL;
+    bool any = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "w:n:W:k:b:r:s:Rf:o:h")) != -1) {
+        switch (opt) {
+            case 'w':
+                if (parse_workloads(optarg, selected) != 0) return -1;
+                any = true;
+                break;
+            case 'n': cfg.iterations = strtoul(optarg, NULL, 0); break;
+            case 'W': cfg.warmup = strtoul(optarg, NULL, 0); break;
+            case 'k': cfg.n_ranks = strtoul(optarg, NULL, 0); break;
+            case 'b': cfg.n_banks = strtoul(optarg, NULL, 0); break;
+            case 'r': cfg.n_rows = strtoul(optarg, NULL, 0); break;
+            case 's': cfg.seed = strtoul(optarg, NULL, 16); break;
+            case 'R': cfg.refresh = true; break;
+            case 'f':
+                if (strcmp(optarg, "text") == 0) format = FORMAT_TEXT;
+                else if (strcmp(optarg, "json") == 0) format = FORMAT_JSON;
+                else if (strcmp(optarg, "csv") == 0) format = FORMAT_CSV;
+                else {
+                    usage(argv[0]);
+                    return -1;
+                }
+                break;
+            case 'o': out_path = optarg; break;
+            default:
+                usage(argv[0]);
+                return -1;
+        }
+    }
+    if (!any) {
+        for (uint32_t i = 0; i < N_WORKLOADS; i++) selected[i] = true;
+    }
+    if (cfg.iterations < 1 || cfg.n_ranks < 1 || cfg.n_ranks > MAX_RANKS || cfg.n_banks < 1 || cfg.n_banks > 16 || cfg.n_rows < 1) {
+        fprintf(stderr, "Invalid benchmark size: %u iterations, %u ranks, %u banks, %u rows\n",
+                cfg.iterations, cfg.n_ranks, cfg.n_banks, cfg.n_rows);
+        return -1;
+    }
+
+    FILE *out = stdout;
+    if (out_path != NULL) {
+        out = fopen(out_path, "w");
+        if (out == NULL) {
+            perror("Failed to open output file");
+            return -1;
+        }
+    }
+    cfg.data_buf = malloc(ROW_BYTES);
+    double *lat = malloc(cfg.iterations * sizeof(double));
+    if (cfg.data_buf == NULL || lat == NULL || cmd_buf_init(&cfg.submit_cb, SUBMIT_BUF_WORDS) != 0) {
+        perror("Failed to allocate benchmark buffers");
+        return -1;
+    }
+
+    // Initialize hardware (progress to stderr, results may go to stdout)
+    if (setup_hardware() != 0) return -1;
+    fprintf(stderr, "Hardware mapped successfully.\n");
+
+    int ret = 0;
+    bool first = true;
+    print_header(out, format, &cfg);
+    for (uint32_t i = 0; i < N_WORKLOADS; i++) {
+        if (!selected[i]) continue;
+        fprintf(stderr, "Running %s...\n", workloads[i].name);
+        bench_result_t res;
+        if (bench_run(&cfg, &workloads[i], lat, &res) != 0) {
+            ret = -1;
+            break;
+        }
+        print_result(out, format, &res, first);
+        first = false;
+        if (workloads[i].op == op_pattern_submit) {
+            fprintf(stderr, "%s: %llu rows generated while out of CMD FIFO credits\n",
+                    workloads[i].name, (unsigned long long)cfg.submit_gens);
+        }
+    }
+    print_footer(out, format);
+
+    // Cleanup
+    cleanup_hardware();
+    if (out != stdout) fclose(out);
+    cmd_buf_free(&cfg.submit_cb);
+    free(cfg.data_buf);
+    free(lat);
+
+    return ret;
+}
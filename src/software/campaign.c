@@ -0,0 +1,278 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "api.h"
+#include "campaign.h"
+
+#define CACHE_LINE 64
+
+// Row Buffer
+typedef struct {
+    uint32_t data[16*128];
+    uint8_t bank_addr;
+    uint8_t rank_addr;
+    uint32_t row_addr;
+} row_slot_t;
+
+// SPSC Queue (lock-free, one producer thread and one consumer thread)
+// head is only written by the consumer and tail only by the producer, each on
+// its own cache line. A NULL entry marks the end of the stream.
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic uint32_t head;
+    _Alignas(CACHE_LINE) _Atomic uint32_t tail;
+    _Alignas(CACHE_LINE) row_slot_t **entries;
+    uint32_t mask; // Capacity - 1 (power of two)
+} spsc_t;
+
+// Phase State (shared by the submission thread and one worker thread)
+typedef struct {
+    const campaign_cfg_t *cfg;
+    spsc_t to_worker;   // Generator: free buffers / Checker: read rows
+    spsc_t from_worker; // Generator: generated rows / Checker: free buffers
+    _Atomic bool stop;
+    uint32_t rows_checked;
+    uint64_t stalls;    // Worker waits
+} phase_t;
+
+// SPSC Queue Initialize
+static int spsc_init(spsc_t *q, uint32_t capacity) {
+    uint32_t size = 1;
+    while (size < capacity) size <<= 1;
+    q->entries = (row_slot_t **)calloc(size, sizeof(row_slot_t *));
+    if (q->entries == NULL) {
+        perror("Failed to allocate SPSC queue");
+        return -1;
+    }
+    q->mask = size - 1;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    return 0;
+}
+
+// SPSC Queue Free
+static void spsc_free(spsc_t *q) {
+    free(q->entries);
+    q->entries = NULL;
+}
+
+// SPSC Queue Push (producer), false when full
+static bool spsc_try_push(spsc_t *q, row_slot_t *slot) {
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (tail - head > q->mask) return false;
+    q->entries[tail & q->mask] = slot;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// SPSC Queue Pop (consumer), false when empty
+static bool spsc_try_pop(spsc_t *q, row_slot_t **slot) {
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    if (head == tail) return false;
+    *slot = q->entries[head & q->mask];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return true;
+}
+
+// SPSC Queue Push (spins while full, the queues are sized so it never is)
+static void spsc_push(spsc_t *q, row_slot_t *slot) {
+    while (!spsc_try_push(q, slot)) {
+        sched_yield();
+    }
+}
+
+// SPSC Queue Pop (spins while empty), counts a stall when it has to wait
+static row_slot_t *spsc_pop(spsc_t *q, uint64_t *stalls) {
+    row_slot_t *slot;
+    if (spsc_try_pop(q, &slot)) return slot;
+    (*stalls)++;
+    while (!spsc_try_pop(q, &slot)) {
+        sched_yield();
+    }
+    return slot;
+}
+
+// Pin a thread to a core (-1: leave it unpinned)
+// A core that does not exist (e.g. a smaller host running the DDR4 model)
+// only gives a warning and the thread runs unpinned.
+static void pin_thread(pthread_t thread, int cpu) {
+    if (cpu < 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int err = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if (err != 0) {
+        fprintf(stderr, "Warning: failed to pin thread to core %d: %s\n", cpu, strerror(err));
+    }
+}
+
+// Row Address of the n-th row (rank by rank, bank by bank, row by row)
+static void row_address(const campaign_cfg_t *cfg, uint32_t n, row_slot_t *slot) {
+    slot->row_addr = n % cfg->n_rows;
+    slot->bank_addr = (n / cfg->n_rows) % cfg->n_banks;
+    slot->rank_addr = n / (cfg->n_rows * cfg->n_banks);
+}
+
+// Generator Thread
+// Takes free buffers from the submission thread and returns generated rows.
+static void *gen_thread(void *arg) {
+    phase_t *ph = (phase_t *)arg;
+    const campaign_cfg_t *cfg = ph->cfg;
+    const uint32_t total = cfg->n_ranks * cfg->n_banks * cfg->n_rows;
+    for (uint32_t n = 0; n < total; n++) {
+        row_slot_t *slot = spsc_pop(&ph->to_worker, &ph->stalls);
+        row_address(cfg, n, slot);
+        cfg->gen(slot->data, slot->bank_addr, slot->row_addr, slot->rank_addr, cfg->arg);
+        spsc_push(&ph->from_worker, slot);
+    }
+    return NULL;
+}
+
+// Checker Thread
+// Checks read rows until the end marker and returns the buffers. After a
+// rejected row the remaining rows are returned unchecked.
+static void *check_thread(void *arg) {
+    phase_t *ph = (phase_t *)arg;
+    const campaign_cfg_t *cfg = ph->cfg;
+    row_slot_t *slot;
+    while ((slot = spsc_pop(&ph->to_worker, &ph->stalls)) != NULL) {
+        if (!atomic_load_explicit(&ph->stop, memory_order_relaxed)) {
+            if (cfg->check(slot->data, slot->bank_addr, slot->row_addr, slot->rank_addr, cfg->arg) != 0) {
+                atomic_store_explicit(&ph->stop, true, memory_order_relaxed);
+            }
+            ph->rows_checked++;
+        }
+        spsc_push(&ph->from_worker, slot);
+    }
+    return NULL;
+}
+
+// Phase Initialize (all buffers start on the free side)
+static int phase_init(phase_t *ph, const campaign_cfg_t *cfg, row_slot_t *slots, bool free_to_worker) {
+    ph->cfg = cfg;
+    ph->rows_checked = 0;
+    ph->stalls = 0;
+    atomic_init(&ph->stop, false);
+    // Room for every buffer and the end marker, so pushes never wait
+    if (spsc_init(&ph->to_worker, cfg->depth + 1) != 0) return -1;
+    if (spsc_init(&ph->from_worker, cfg->depth + 1) != 0) {
+        spsc_free(&ph->to_worker);
+        return -1;
+    }
+    for (uint32_t i = 0; i < cfg->depth; i++) {
+        spsc_push(free_to_worker ? &ph->to_worker : &ph->from_worker, &slots[i]);
+    }
+    return 0;
+}
+
+// Phase Free
+static void phase_free(phase_t *ph) {
+    spsc_free(&ph->to_worker);
+    spsc_free(&ph->from_worker);
+}
+
+// Worker Thread Start
+static int worker_start(pthread_t *thread, void *(*fn)(void *), phase_t *ph, int cpu) {
+    int err = pthread_create(thread, NULL, fn, ph);
+    if (err != 0) {
+        fprintf(stderr, "Failed to create campaign thread: %s\n", strerror(err));
+        return -1;
+    }
+    pin_thread(*thread, cpu);
+    return 0;
+}
+
+// Campaign Default Configuration
+// The submission thread runs on core 1 and the workers on cores 2 and 3,
+// which leaves core 0 to the kernel (DMA interrupts) and the shell.
+void campaign_cfg_default(campaign_cfg_t *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->n_ranks = 1;
+    cfg->n_banks = 16;
+    cfg->n_rows = 256;
+    cfg->refresh = true;
+    cfg->depth = 8;
+    cfg->gen_cpu = 2;
+    cfg->submit_cpu = 1;
+    cfg->check_cpu = 3;
+}
+
+// Campaign Run
+// Write phase: generator thread -> submission thread (write_row_batch).
+// Read phase: submission thread (read_row) -> checker thread.
+// Returns -1 on a setup error or when the check callback stopped the campaign.
+int campaign_run(const campaign_cfg_t *cfg, campaign_result_t *result) {
+    const uint32_t total = cfg->n_ranks * cfg->n_banks * cfg->n_rows;
+    memset(result, 0, sizeof(*result));
+    if (cfg->n_ranks < 1 || cfg->n_ranks > MAX_RANKS || cfg->depth < 1 || cfg->gen == NULL || cfg->check == NULL) {
+        fprintf(stderr, "Invalid campaign configuration\n");
+        return -1;
+    }
+
+    row_slot_t *slots;
+    if (posix_memalign((void **)&slots, CACHE_LINE, cfg->depth * sizeof(row_slot_t)) != 0) {
+        fprintf(stderr, "Failed to allocate campaign row buffers\n");
+        return -1;
+    }
+
+    // Pin the submission (calling) thread, restored on return
+    cpu_set_t saved_set;
+    pthread_getaffinity_np(pthread_self(), sizeof(saved_set), &saved_set);
+    pin_thread(pthread_self(), cfg->submit_cpu);
+
+    int ret = -1;
+    pthread_t thread;
+    phase_t ph;
+
+    // Write phase
+    if (phase_init(&ph, cfg, slots, true) != 0) goto out;
+    if (worker_start(&thread, gen_thread, &ph, cfg->gen_cpu) != 0) {
+        phase_free(&ph);
+        goto out;
+    }
+    for (uint32_t n = 0; n < total; n++) {
+        row_slot_t *slot = spsc_pop(&ph.from_worker, &result->submit_stalls);
+        result->nck += write_row_batch(slot->data, slot->bank_addr, slot->row_addr, slot->rank_addr);
+        if (cfg->refresh) result->nck += all_bank_refresh(slot->rank_addr);
+        result->rows_written++;
+        spsc_push(&ph.to_worker, slot);
+    }
+    pthread_join(thread, NULL);
+    result->gen_stalls = ph.stalls;
+    phase_free(&ph);
+
+    // Read phase
+    if (phase_init(&ph, cfg, slots, false) != 0) goto out;
+    if (worker_start(&thread, check_thread, &ph, cfg->check_cpu) != 0) {
+        phase_free(&ph);
+        goto out;
+    }
+    for (uint32_t n = 0; n < total && !atomic_load_explicit(&ph.stop, memory_order_relaxed); n++) {
+        row_slot_t *slot = spsc_pop(&ph.from_worker, &result->submit_stalls);
+        row_address(cfg, n, slot);
+        result->nck += read_row(slot->data, slot->bank_addr, slot->row_addr, slot->rank_addr);
+        if (cfg->refresh) result->nck += all_bank_refresh(slot->rank_addr);
+        result->rows_read++;
+        spsc_push(&ph.to_worker, slot);
+    }
+    spsc_push(&ph.to_worker, NULL); // End marker
+    pthread_join(thread, NULL);
+    result->rows_checked = ph.rows_checked;
+    result->check_stalls = ph.stalls;
+    result->stopped = atomic_load(&ph.stop);
+    phase_free(&ph);
+    ret = result->stopped ? -1 : 0;
+
+out:
+    pthread_setaffinity_np(pthread_self(), sizeof(saved_set), &saved_set);
+    free(slots);
+    return ret;
+}
@@ -0,0 +1,43 @@
+#ifndef CAMPAIGN_H
+#define CAMPAIGN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "api.h"
+
+// Campaign Configuration
+// A campaign writes every row (rank by rank, bank by bank, row by row) and
+// then reads them back. Pattern generation, command/DMA submission and
+// verification/logging run on separate threads, connected by SPSC queues of
+// row buffers. Only the submission thread touches the hardware.
+typedef struct {
+    uint8_t n_ranks;
+    uint8_t n_banks;
+    uint32_t n_rows;
+    bool refresh;          // All-bank refresh after every row
+    uint32_t depth;        // Row buffers per phase (rows the threads may run ahead)
+    row_gen_fn_t gen;      // Called on the generator thread
+    row_check_fn_t check;  // Called on the checker thread, non-zero to stop
+    void *arg;             // Passed to gen and check
+    int gen_cpu;           // Cores the threads are pinned to (-1: not pinned)
+    int submit_cpu;        // The calling thread is the submission thread
+    int check_cpu;
+} campaign_cfg_t;
+
+// Campaign Result
+typedef struct {
+    uint32_t rows_written;
+    uint32_t rows_read;
+    uint32_t rows_checked;
+    uint64_t nck;           // Ideal DRAM cycles of the submitted commands
+    uint64_t gen_stalls;    // Generator waits for a free buffer (submission-bound)
+    uint64_t submit_stalls; // Submission waits for a row/buffer (generator/checker-bound)
+    uint64_t check_stalls;  // Checker waits for a read row (submission-bound)
+    bool stopped;           // The check callback stopped the campaign
+} campaign_result_t;
+
+void campaign_cfg_default(campaign_cfg_t *cfg);
+int campaign_run(const campaign_cfg_t *cfg, campaign_result_t *result);
+
+#endif
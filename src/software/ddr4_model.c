@@ -0,0 +1,833 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "api.h"
+#include "backend.h"
+#include "timing.h"
+#include "utils.h"
+
+// DDR4 Model Backend
+// Runs the command stream in-process the way the fabric does, so the test
+// programs and the host-side code can be run and profiled without the board:
+//   - Command words are framed like the AXI bridge (a slot without the strict
+//     flag ends the 128-bit word) and issued one per fabric cycle, slot s of
+//     the word at DRAM cycle 4 * cycle + s; WAIT holds the next word back
+//   - Bank/row state is tracked per rank and bank and every command is
+//     checked against the active timing profile (timing.h, loaded by
+//     timing_load in timing.c); violations are reported, not fixed
+//   - Row data is stored sparsely (rows are allocated on their first WR,
+//     unwritten rows read as zero)
+//   - Pattern WRs, compare RDs, CFG registers, the loop engine and the
+//     performance counters behave like wdata_pattern_gen, rdata_comparator,
+//     loop_engine and perf_counters
+//   - The AXI DMA is modeled in scatter-gather mode only; MM2S descriptors
+//     complete at once and S2MM descriptors as read data arrives
+// Time only advances with the command stream, so there are no host-bound
+// (CMD empty) or WDATA stall cycles; a WR without host data holds the
+// stream until it arrives, as the scheduler does.
+
+#define MODEL_UDMABUF_SIZE  (1 << 20)    // 1MB
+#define MODEL_UDMABUF_PHYS  0x70000000ul // Physical address reported for the udmabuf
+#define MODEL_REG_BYTES     0x100        // DMA/GPIO register windows
+#define MODEL_ROW_BUCKETS   4096         // Row store hash buckets
+#define MODEL_RDATA_DEPTH   16           // RDATA FIFO (beats held without an S2MM descriptor)
+#define MODEL_S2MM_DEPTH    64           // Armed S2MM descriptors
+#define MODEL_MAX_REPORTS   16           // Timing violations printed
+#define MODEL_BANKS         16
+#define MODEL_RANKS         2
+#define ROW_WORDS           (16 * 128)
+#define BEAT_WORDS          16
+#define NEVER               (-(1ll << 40)) // Time of a command that never happened
+
+// Performance counter indices (perf_snapshot order)
+enum {
+    PC_CYCLES, PC_CMD_WORDS, PC_WDATA_BEATS, PC_ISSUED_WORDS, PC_WR_WORDS,
+    PC_WDATA_STALL, PC_WAIT, PC_CMD_EMPTY, PC_RDATA_OVERFLOWS,
+    PC_ACT, PC_PRE, PC_RD, PC_WR, PC_REF, PC_ZQ, PC_RD_BEATS,
+    PC_EVENTS
+};
+
+// Stored Row
+typedef struct row_entry {
+    uint64_t key;
+    struct row_entry *next;
+    uint32_t data[ROW_WORDS];
+} row_entry_t;
+
+// Bank State
+typedef struct {
+    bool open;
+    uint32_t row;
+    int64_t t_act; // DRAM cycle of the last ACT
+    int64_t t_pre; // DRAM cycle of the last PRE
+} bank_t;
+
+// Beat Queue (wdata / rdata)
+typedef struct {
+    uint32_t (*beats)[BEAT_WORDS];
+    bool *last;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+} beat_queue_t;
+
+// DMA Channel (scatter-gather registers)
+typedef struct {
+    uint32_t cr;
+    uint32_t curdesc;
+    uint32_t taildesc;
+    uint32_t next; // Next descriptor to fetch
+} dma_chan_t;
+
+static struct {
+    uint32_t *dma_regs;
+    uint32_t *gpio_regs;
+    dma_chan_t mm2s;
+    dma_chan_t s2mm;
+    uint32_t s2mm_desc[MODEL_S2MM_DEPTH]; // Armed S2MM descriptors (physical)
+    uint32_t s2mm_head;
+    uint32_t s2mm_count;
+    uint32_t s2mm_fill;                   // Bytes written to the head descriptor
+    beat_queue_t wdata;
+    beat_queue_t rdata;
+    // Command stream
+    uint32_t (*words)[4];                 // Host command words not yet issued
+    uint32_t words_cap;
+    uint32_t words_head;
+    uint32_t words_count;
+    uint32_t slots[4];                    // Word being framed
+    uint32_t n_slots;
+    uint64_t cycle;                       // Fabric cycle of the next word
+    // DRAM
+    bank_t banks[MODEL_RANKS][MODEL_BANKS];
+    int64_t t_ref[MODEL_RANKS];
+    int64_t t_col;                        // Last RD/WR
+    uint8_t col_bank;
+    uint8_t col_rank;
+    row_entry_t *rows[MODEL_ROW_BUCKETS];
+    uint64_t n_rows;
+    // Patterns
+    uint32_t seed;
+    uint32_t pat_buf[ROW_WORDS];          // Last generated pattern row
+    uint64_t pat_key;
+    bool pat_valid;
+    // Compare batch
+    uint32_t cmp_beats;
+    uint32_t cmp_mismatches;
+    uint32_t cmp_flips;
+    // Loop engine
+    uint64_t imem[IMEM_DEPTH];
+    uint32_t load_addr;
+    uint64_t load_instr;
+    uint32_t regs[8];
+    uint32_t pc;
+    bool running;
+    bool done_toggle;
+    // Performance counters
+    uint64_t perf[PC_EVENTS];
+    uint64_t shadow[PERF_COUNTERS];
+    uint64_t first_issue;
+    uint64_t last_issue;
+    bool window_open;
+    uint32_t gpio_ctrl;
+    // Checks
+    uint64_t n_commands;
+    uint64_t n_violations;
+} m;
+
+// Timing Violation
+static void model_violation(const char *fmt, ...) {
+    if (m.n_violations++ < MODEL_MAX_REPORTS) {
+        va_list ap;
+        va_start(ap, fmt);
+        fprintf(stderr, "DDR4 model: ");
+        vfprintf(stderr, fmt, ap);
+        fprintf(stderr, "\n");
+        va_end(ap);
+    }
+}
+
+// Timing Check (cycles from the earlier command at t_prev to T)
+static void model_check(const char *name, int64_t T, int64_t t_prev, uint32_t n, uint8_t bank_addr) {
+    if (T - t_prev < n) {
+        model_violation("%s violation at nCK %lld, bank %u: %lld < %u", name, (long long)T, bank_addr, (long long)(T - t_prev), n);
+    }
+}
+
+// Physical to Host Address (udmabuf)
+static void *model_phys(uint32_t phys, uint32_t length) {
+    if (phys < udmabuf_phys_addr || phys + length > udmabuf_phys_addr + udmabuf_size) {
+        fprintf(stderr, "DDR4 model: DMA address 0x%08X (%u bytes) outside the udmabuf\n", phys, length);
+        exit(1);
+    }
+    return (uint8_t *)udmabuf_vptr + (phys - udmabuf_phys_addr);
+}
+
+// Beat Queue Push (grows unless capacity is fixed)
+static bool beat_push(beat_queue_t *q, const uint32_t *beat, bool last, bool grow) {
+    if (q->count == q->capacity) {
+        if (!grow) return false;
+        uint32_t capacity = q->capacity ? 2 * q->capacity : 64;
+        uint32_t (*beats)[BEAT_WORDS] = malloc(capacity * sizeof(*beats));
+        bool *lasts = malloc(capacity * sizeof(bool));
+        if (beats == NULL || lasts == NULL) {
+            perror("DDR4 model: failed to allocate beat queue");
+            exit(1);
+        }
+        for (uint32_t i = 0; i < q->count; i++) {
+            memcpy(beats[i], q->beats[(q->head + i) % q->capacity], sizeof(beats[i]));
+            lasts[i] = q->last[(q->head + i) % q->capacity];
+        }
+        free(q->beats);
+        free(q->last);
+        q->beats = beats;
+        q->last = lasts;
+        q->capacity = capacity;
+        q->head = 0;
+    }
+    uint32_t i = (q->head + q->count) % q->capacity;
+    memcpy(q->beats[i], beat, sizeof(q->beats[i]));
+    q->last[i] = last;
+    q->count++;
+    return true;
+}
+
+// Beat Queue Pop
+static void beat_pop(beat_queue_t *q, uint32_t *beat, bool *last) {
+    memcpy(beat, q->beats[q->head], sizeof(q->beats[q->head]));
+    if (last) *last = q->last[q->head];
+    q->head = (q->head + 1) % q->capacity;
+    q->count--;
+}
+
+// Beat Queue Free
+static void beat_free(beat_queue_t *q) {
+    free(q->beats);
+    free(q->last);
+    memset(q, 0, sizeof(*q));
+}
+
+// Row Lookup (creates a zeroed row if create is set)
+static row_entry_t *row_lookup(uint8_t rank_addr, uint8_t bank_addr, uint32_t row_addr, bool create) {
+    uint64_t key = ((uint64_t)rank_addr << 40) | ((uint64_t)bank_addr << 32) | row_addr;
+    uint32_t bucket = (row_addr * 32 + rank_addr * 16 + bank_addr) % MODEL_ROW_BUCKETS;
+    for (row_entry_t *e = m.rows[bucket]; e != NULL; e = e->next) {
+        if (e->key == key) return e;
+    }
+    if (!create) return NULL;
+    row_entry_t *e = calloc(1, sizeof(row_entry_t));
+    if (e == NULL) {
+        perror("DDR4 model: failed to allocate row");
+        exit(1);
+    }
+    e->key = key;
+    e->next = m.rows[bucket];
+    m.rows[bucket] = e;
+    m.n_rows++;
+    return e;
+}
+
+// Pattern Beat (gen_pattern, the last row is cached)
+static const uint32_t *pattern_beat(uint8_t pattern_id, uint8_t rank_addr, uint8_t bank_addr, uint32_t row_addr, uint16_t col_addr) {
+    uint64_t key = ((uint64_t)m.seed << 32) ^ ((uint64_t)pattern_id << 28) ^ ((uint64_t)bank_addr << 24) ^ ((uint64_t)rank_addr << 23) ^ row_addr;
+    if (!m.pat_valid || m.pat_key != key) {
+        gen_pattern(m.pat_buf, pattern_id, bank_addr, row_addr, rank_addr, m.seed);
+        m.pat_key = key;
+        m.pat_valid = true;
+    }
+    return m.pat_buf + (col_addr / 8) * BEAT_WORDS;
+}
+
+// S2MM Write (one beat into the head descriptor)
+static void s2mm_write(const uint32_t *beat, bool last) {
+    uint32_t *d = model_phys(m.s2mm_desc[m.s2mm_head], SG_DESC_SIZE);
+    uint32_t length = d[SG_DESC_CONTROL / 4] & 0x3FFFFFF;
+    if (m.s2mm_fill + BEAT_WORDS * 4 <= length) {
+        memcpy(model_phys(d[SG_DESC_BUFFER_ADDR / 4] + m.s2mm_fill, BEAT_WORDS * 4), beat, BEAT_WORDS * 4);
+        m.s2mm_fill += BEAT_WORDS * 4;
+    }
+    if (last || m.s2mm_fill >= length) {
+        d[SG_DESC_STATUS / 4] = SG_STS_CMPLT | (last ? SG_STS_RXEOF : 0) | m.s2mm_fill;
+        m.s2mm_head = (m.s2mm_head + 1) % MODEL_S2MM_DEPTH;
+        m.s2mm_count--;
+        m.s2mm_fill = 0;
+    }
+}
+
+// Read Data Output (to S2MM, or the RDATA FIFO without a descriptor)
+static void rdata_push(const uint32_t *beat, bool last) {
+    if (m.s2mm_count > 0 && m.rdata.count == 0) {
+        s2mm_write(beat, last);
+    } else if (!beat_push(&m.rdata, beat, last, false)) {
+        m.perf[PC_RDATA_OVERFLOWS]++;
+    }
+}
+
+// RDATA FIFO Drain (into armed S2MM descriptors)
+static void rdata_drain(void) {
+    uint32_t beat[BEAT_WORDS];
+    bool last;
+    while (m.s2mm_count > 0 && m.rdata.count > 0) {
+        beat_pop(&m.rdata, beat, &last);
+        s2mm_write(beat, last);
+    }
+}
+
+// Issue Window Update (DRAM cycles of the first and last command of a word)
+static void issue_window(bool mark, int64_t first, int64_t last) {
+    if (mark) {
+        m.window_open = false;
+        m.first_issue = 0;
+        m.last_issue = 0;
+    }
+    if (first < 0) return;
+    if (!m.window_open) {
+        m.first_issue = first;
+        m.window_open = true;
+    }
+    m.last_issue = last;
+}
+
+// Column Command (RD/WR) timing and bank checks
+// Column commands to another rank only share the data bus (tCCD_S).
+static bool col_check(const char *name, int64_t T, uint8_t rank_addr, uint8_t bank_addr) {
+    bank_t *b = &m.banks[rank_addr][bank_addr];
+    if (!b->open) {
+        model_violation("%s to closed bank at nCK %lld, rank %u bank %u", name, (long long)T, rank_addr, bank_addr);
+        return false;
+    }
+    model_check("tRCD", T, b->t_act, timing.tRCD, bank_addr);
+    bool same_group = m.col_rank == rank_addr && (m.col_bank >> 2) == (bank_addr >> 2);
+    model_check(same_group ? "tCCD_L" : "tCCD_S", T, m.t_col, same_group ? timing.tCCD_L : timing.tCCD_S, bank_addr);
+    m.t_col = T;
+    m.col_bank = bank_addr;
+    m.col_rank = rank_addr;
+    return true;
+}
+
+// Read (plain RDs return the data, compare RDs return records)
+static void model_read(uint32_t slot, int64_t T) {
+    uint8_t bank_addr = (slot >> 3) & 0xF;
+    uint8_t rank_addr = (slot >> 24) & 0x1;
+    uint16_t col_addr = (slot >> 7) & 0x3FF;
+    uint8_t pattern_id = (slot >> 17) & 0x7;
+    bool last = !((slot >> 30) & 1);
+    uint32_t beat[BEAT_WORDS] = { 0 };
+    uint32_t row_addr = m.banks[rank_addr][bank_addr].row;
+    if (col_check("RD", T, rank_addr, bank_addr)) {
+        row_entry_t *e = row_lookup(rank_addr, bank_addr, row_addr, false);
+        if (e != NULL) memcpy(beat, e->data + (col_addr / 8) * BEAT_WORDS, sizeof(beat));
+    }
+    m.perf[PC_RD_BEATS]++;
+    if (pattern_id == PATTERN_HOST) {
+        rdata_push(beat, last);
+        return;
+    }
+    const uint32_t *expected = pattern_beat(pattern_id, rank_addr, bank_addr, row_addr, col_addr);
+    uint32_t mask[BEAT_WORDS];
+    uint32_t flips = 0;
+    for (int j = 0; j < BEAT_WORDS; j++) {
+        mask[j] = beat[j] ^ expected[j];
+        flips += __builtin_popcount(mask[j]);
+    }
+    m.cmp_beats++;
+    if (flips > 0) {
+        uint32_t header[BEAT_WORDS] = { CMP_REC_MISMATCH, bank_addr, row_addr, col_addr, flips };
+        rdata_push(header, false);
+        rdata_push(mask, false);
+        m.cmp_mismatches++;
+        m.cmp_flips += flips;
+    }
+    if (last) {
+        uint32_t summary[BEAT_WORDS] = { CMP_REC_SUMMARY, m.cmp_beats, m.cmp_mismatches, m.cmp_flips, 0 };
+        rdata_push(summary, true);
+        m.cmp_beats = 0;
+        m.cmp_mismatches = 0;
+        m.cmp_flips = 0;
+    }
+}
+
+// Write (one host beat is shared by the host WRs of a word)
+static void model_write(uint32_t slot, int64_t T, const uint32_t *host_beat) {
+    uint8_t bank_addr = (slot >> 3) & 0xF;
+    uint8_t rank_addr = (slot >> 24) & 0x1;
+    uint16_t col_addr = (slot >> 7) & 0x3FF;
+    uint8_t pattern_id = (slot >> 17) & 0x7;
+    if (!col_check("WR", T, rank_addr, bank_addr)) return;
+    uint32_t row_addr = m.banks[rank_addr][bank_addr].row;
+    const uint32_t *data = pattern_id == PATTERN_HOST ? host_beat : pattern_beat(pattern_id, rank_addr, bank_addr, row_addr, col_addr);
+    row_entry_t *e = row_lookup(rank_addr, bank_addr, row_addr, true);
+    memcpy(e->data + (col_addr / 8) * BEAT_WORDS, data, BEAT_WORDS * 4);
+}
+
+// Precharge (one bank)
+static void model_precharge(uint8_t rank_addr, uint8_t bank_addr, int64_t T) {
+    bank_t *b = &m.banks[rank_addr][bank_addr];
+    if (b->open) {
+        model_check("tRAS", T, b->t_act, timing.tRAS, bank_addr);
+        b->open = false;
+    }
+    b->t_pre = T;
+}
+
+// Word Issue
+// Returns false (nothing issued) when the word has a host WR and no write
+// data has arrived yet.
+static bool model_issue(const uint32_t *word, bool host) {
+    uint32_t host_beat[BEAT_WORDS] = { 0 };
+    bool has_host_wr = false;
+    bool has_wr = false;
+    for (int s = 0; s < 4; s++) {
+        if ((word[s] & 0x7) == 4) {
+            has_wr = true;
+            if (((word[s] >> 17) & 0x7) == PATTERN_HOST) has_host_wr = true;
+        }
+    }
+    if (has_host_wr) {
+        if (m.wdata.count == 0) return false;
+        beat_pop(&m.wdata, host_beat, NULL);
+    }
+
+    uint64_t wait_total = 0;
+    bool mark = false;
+    bool start = false;
+    uint32_t start_addr = 0;
+    int64_t first = -1, last = -1;
+    for (int s = 0; s < 4; s++) {
+        uint32_t slot = word[s];
+        int64_t T = (int64_t)m.cycle * 4 + s;
+        uint8_t bank_addr = (slot >> 3) & 0xF;
+        uint8_t rank_addr = (slot >> 24) & 0x1;
+        bool issued = true;
+        switch (slot & 0x7) {
+            case 1: // PRE
+                if ((slot >> 7) & 1) {
+                    for (int b = 0; b < MODEL_BANKS; b++) model_precharge(rank_addr, b, T);
+                } else {
+                    model_precharge(rank_addr, bank_addr, T);
+                }
+                m.perf[PC_PRE]++;
+                break;
+            case 2: { // ACT
+                bank_t *b = &m.banks[rank_addr][bank_addr];
+                if (b->open) {
+                    model_violation("ACT to open bank at nCK %lld, rank %u bank %u", (long long)T, rank_addr, bank_addr);
+                }
+                model_check("tRP", T, b->t_pre, timing.tRP, bank_addr);
+                model_check("tRFC", T, m.t_ref[rank_addr], timing.tRFC, bank_addr);
+                b->open = true;
+                b->row = (slot >> 7) & 0x1FFFF;
+                b->t_act = T;
+                m.perf[PC_ACT]++;
+                break;
+            }
+            case 3: // RD
+                model_read(slot, T);
+                m.perf[PC_RD]++;
+                break;
+            case 4: // WR
+                model_write(slot, T, host_beat);
+                m.perf[PC_WR]++;
+                break;
+            case 5: // REF (one rank)
+                for (int b = 0; b < MODEL_BANKS; b++) {
+                    if (m.banks[rank_addr][b].open) {
+                        model_violation("REF with open bank at nCK %lld, rank %u bank %u", (long long)T, rank_addr, b);
+                    }
+                    model_check("tRP", T, m.banks[rank_addr][b].t_pre, timing.tRP, b);
+                }
+                model_check("tRFC", T, m.t_ref[rank_addr], timing.tRFC, 0);
+                m.t_ref[rank_addr] = T;
+                m.perf[PC_REF]++;
+                break;
+            case 6: // ZQ
+                m.perf[PC_ZQ]++;
+                break;
+            case 7: { // WAIT / CFG
+                issued = false;
+                if (!((slot >> 30) & 1)) {
+                    wait_total += (slot >> 3) & WAIT_MAX_COUNT;
+                    break;
+                }
+                uint32_t value = (slot >> 10) & 0xFFFF;
+                switch ((slot >> 26) & 0xF) {
+                    case CFG_SEED_LO: m.seed = (m.seed & 0xFFFF0000) | value; break;
+                    case CFG_SEED_HI: m.seed = (m.seed & 0x0000FFFF) | (value << 16); break;
+                    case CFG_ISSUE_MARK: mark = true; break;
+                    default: break;
+                }
+                // IMEM load and start are scanned on host words only (loop_engine.v)
+                if (!host) break;
+                switch ((slot >> 26) & 0xF) {
+                    case CFG_IMEM_ADDR: m.load_addr = value & (IMEM_DEPTH - 1); break;
+                    case CFG_INSTR_0: m.load_instr = (m.load_instr & ~0xFFFFull) | value; break;
+                    case CFG_INSTR_1: m.load_instr = (m.load_instr & ~(0xFFFFull << 16)) | ((uint64_t)value << 16); break;
+                    case CFG_INSTR_2: m.load_instr = (m.load_instr & ~(0xFFFFull << 32)) | ((uint64_t)value << 32); break;
+                    case CFG_INSTR_3:
+                        m.load_instr = (m.load_instr & ~(0xFFFFull << 48)) | ((uint64_t)value << 48);
+                        m.imem[m.load_addr] = m.load_instr;
+                        m.load_addr = (m.load_addr + 1) & (IMEM_DEPTH - 1);
+                        break;
+                    case CFG_START:
+                        start = true;
+                        start_addr = value & (IMEM_DEPTH - 1);
+                        break;
+                    default: break;
+                }
+                break;
+            }
+            default: // NOP
+                issued = false;
+                break;
+        }
+        if (issued) {
+            m.n_commands++;
+            if (first < 0) first = T;
+            last = T;
+        }
+    }
+    issue_window(mark, first, last);
+
+    m.perf[PC_CMD_WORDS]++;
+    m.perf[PC_ISSUED_WORDS]++;
+    if (has_wr) m.perf[PC_WR_WORDS]++;
+    m.perf[PC_WAIT] += wait_total;
+    m.perf[PC_CYCLES] += 1 + wait_total;
+    m.cycle += 1 + wait_total;
+    if (start) {
+        m.running = true;
+        m.pc = start_addr;
+    }
+    return true;
+}
+
+// Loop Engine Step (one instruction, see loop_engine.v)
+// Returns false when a CMD word is held back for write data.
+static bool engine_step(void) {
+    uint64_t instr = m.imem[m.pc];
+    uint32_t rsel = (instr >> 48) & 0x7;
+    uint32_t target = instr & (IMEM_DEPTH - 1);
+    uint32_t next_pc = (m.pc + 1) & (IMEM_DEPTH - 1);
+    switch (instr >> 60) {
+        case OP_HALT:
+            m.running = false;
+            m.done_toggle = !m.done_toggle;
+            return true;
+        case OP_CMD: {
+            uint32_t slot = instr & 0xFFFFFFFF;
+            if ((instr >> 57) & 1) slot = (slot & ~(0xFu << 3)) | ((m.regs[4] & 0xF) << 3);
+            if ((instr >> 58) & 1) slot = (slot & ~(0x1FFFFu << 7)) | ((m.regs[5] & 0x1FFFF) << 7);
+            if ((instr >> 59) & 1) slot = (slot & ~(0x3FFu << 7)) | ((m.regs[6] & 0x3FF) << 7);
+            uint32_t word[4] = { slot, 0x7 | (((instr >> 32) & PROG_WAIT_MAX) << 3), 0, 0 };
+            if (!model_issue(word, false)) return false;
+            m.pc = next_pc;
+            return true;
+        }
+        case OP_SET:  m.regs[rsel] = instr & 0xFFFFFFFF; break;
+        case OP_ADD:  m.regs[rsel] += instr & 0xFFFFFFFF; break;
+        case OP_LOOP:
+            m.regs[rsel]--;
+            if (m.regs[rsel] != 0) next_pc = target;
+            break;
+        case OP_JUMP: next_pc = target; break;
+        default: break;
+    }
+    // No command word this cycle
+    m.pc = next_pc;
+    m.cycle++;
+    m.perf[PC_CYCLES]++;
+    m.perf[PC_CMD_EMPTY]++;
+    return true;
+}
+
+// Run (until the stream is empty or waits for write data)
+static void model_run(void) {
+    for (;;) {
+        if (m.running) {
+            if (!engine_step()) return;
+        } else if (m.words_count > 0) {
+            if (!model_issue(m.words[m.words_head], true)) return;
+            m.words_head = (m.words_head + 1) % m.words_cap;
+            m.words_count--;
+        } else {
+            return;
+        }
+    }
+}
+
+// Command Word Queue Push
+static void words_push(const uint32_t *word) {
+    if (m.words_count == m.words_cap) {
+        uint32_t capacity = m.words_cap ? 2 * m.words_cap : 1024;
+        uint32_t (*words)[4] = malloc(capacity * sizeof(*words));
+        if (words == NULL) {
+            perror("DDR4 model: failed to allocate command queue");
+            exit(1);
+        }
+        for (uint32_t i = 0; i < m.words_count; i++) {
+            memcpy(words[i], m.words[(m.words_head + i) % m.words_cap], sizeof(words[i]));
+        }
+        free(m.words);
+        m.words = words;
+        m.words_cap = capacity;
+        m.words_head = 0;
+    }
+    memcpy(m.words[(m.words_head + m.words_count) % m.words_cap], word, sizeof(m.words[0]));
+    m.words_count++;
+}
+
+// Bridge Write (AXI bridge framing: TLAST = !strict, 4 slots per word)
+static void model_bridge_write(const uint32_t *words, uint32_t n_words) {
+    for (uint32_t i = 0; i < n_words; i++) {
+        m.slots[m.n_slots++] = words[i];
+        if (m.n_slots == 4 || !(words[i] >> 31)) {
+            while (m.n_slots < 4) m.slots[m.n_slots++] = 0; // NOP
+            words_push(m.slots);
+            m.n_slots = 0;
+        }
+    }
+    model_run();
+}
+
+// Bridge Flush (commands run as they are written)
+static void model_bridge_flush(void) {
+}
+
+// DMA Descriptor Fetch (from next up to and including the tail)
+static void dma_fetch(dma_chan_t *ch, bool mm2s) {
+    if (!(ch->cr & DMACR_RS)) return;
+    for (;;) {
+        uint32_t desc = ch->next;
+        uint32_t *d = model_phys(desc, SG_DESC_SIZE);
+        if (mm2s) {
+            uint32_t length = d[SG_DESC_CONTROL / 4] & 0x3FFFFFF;
+            const uint32_t *data = model_phys(d[SG_DESC_BUFFER_ADDR / 4], length);
+            for (uint32_t off = 0; off + BEAT_WORDS * 4 <= length; off += BEAT_WORDS * 4) {
+                beat_push(&m.wdata, data + off / 4, false, true);
+                m.perf[PC_WDATA_BEATS]++;
+            }
+            d[SG_DESC_STATUS / 4] = SG_STS_CMPLT | length;
+        } else {
+            if (m.s2mm_count == MODEL_S2MM_DEPTH) {
+                fprintf(stderr, "DDR4 model: too many S2MM descriptors\n");
+                exit(1);
+            }
+            m.s2mm_desc[(m.s2mm_head + m.s2mm_count) % MODEL_S2MM_DEPTH] = desc;
+            m.s2mm_count++;
+        }
+        ch->curdesc = desc;
+        ch->next = d[SG_DESC_NXTDESC / 4];
+        if (desc == ch->taildesc) break;
+    }
+    if (mm2s) {
+        model_run();
+    } else {
+        rdata_drain();
+    }
+}
+
+// DMA Register Read
+static uint32_t dma_reg_read(uint32_t offset) {
+    dma_chan_t *ch = offset < S2MM_DMACR ? &m.mm2s : &m.s2mm;
+    switch (offset) {
+        case MM2S_DMACR:
+        case S2MM_DMACR:
+            return ch->cr;
+        case MM2S_DMASR:
+        case S2MM_DMASR: {
+            uint32_t sr = DMASR_SG_INCLD;
+            if (!(ch->cr & DMACR_RS)) sr |= DMASR_HALTED;
+            if (ch == &m.mm2s || m.s2mm_count == 0) sr |= DMASR_IDLE;
+            return sr;
+        }
+        case MM2S_CURDESC:
+        case S2MM_CURDESC:
+            return ch->curdesc;
+        case MM2S_TAILDESC:
+        case S2MM_TAILDESC:
+            return ch->taildesc;
+        default:
+            return 0;
+    }
+}
+
+// DMA Register Write (simple mode registers are ignored)
+static void dma_reg_write(uint32_t offset, uint32_t value) {
+    dma_chan_t *ch = offset < S2MM_DMACR ? &m.mm2s : &m.s2mm;
+    switch (offset) {
+        case MM2S_DMACR:
+        case S2MM_DMACR:
+            if (value & DMACR_RESET) {
+                // Soft reset of both channels, self-clearing
+                memset(&m.mm2s, 0, sizeof(m.mm2s));
+                memset(&m.s2mm, 0, sizeof(m.s2mm));
+                m.s2mm_count = 0;
+                m.s2mm_fill = 0;
+                break;
+            }
+            ch->cr = value;
+            break;
+        case MM2S_CURDESC:
+        case S2MM_CURDESC:
+            ch->curdesc = value;
+            ch->next = value;
+            break;
+        case MM2S_TAILDESC:
+        case S2MM_TAILDESC:
+            ch->taildesc = value;
+            dma_fetch(ch, ch == &m.mm2s);
+            break;
+        default:
+            break;
+    }
+}
+
+// Performance Counter Value (perf_counters.v shadow index)
+static uint64_t perf_value(uint32_t n) {
+    return n < PERF_COUNTERS ? m.shadow[n] : 0;
+}
+
+// GPIO State (channel 1)
+static uint32_t gpio_state(void) {
+    if (m.gpio_ctrl & CTRL_PERF_VIEW) {
+        uint32_t index = (m.gpio_ctrl >> 2) & 0x3F;
+        uint64_t value = perf_value(index >> 1);
+        return (index & 1) ? value >> 32 : value & 0xFFFFFFFF;
+    }
+    if (m.gpio_ctrl & CTRL_DEBUG_VIEW) {
+        return 0; // Scheduler debug view is not modeled
+    }
+    uint32_t cmd_count = m.words_count > 0xFF ? 0xFF : m.words_count;
+    uint32_t wdata_count = m.wdata.count > 0xFF ? 0xFF : m.wdata.count;
+    return (m.running ? STATE_PROG_RUNNING : 0) | (m.done_toggle ? STATE_PROG_DONE : 0) |
+           (m.words_count > 0 ? STATE_PIPE_BUSY : 0) |
+           (cmd_count << 16) | (wdata_count << 8) | m.rdata.count;
+}
+
+// GPIO Control (channel 2, snapshot/clear on rising edges)
+static void gpio_control(uint32_t value) {
+    uint32_t rising = value & ~m.gpio_ctrl;
+    if (rising & CTRL_PERF_CLEAR) {
+        memset(m.perf, 0, sizeof(m.perf));
+        issue_window(true, -1, -1);
+    }
+    if (rising & CTRL_PERF_SNAPSHOT) {
+        memcpy(m.shadow, m.perf, sizeof(m.perf));
+        m.shadow[PC_EVENTS] = m.first_issue;
+        m.shadow[PC_EVENTS + 1] = m.last_issue;
+    }
+    m.gpio_ctrl = value;
+}
+
+// MMIO Read (model backend)
+static uint32_t model_mmio_read(volatile void *addr) {
+    uintptr_t a = (uintptr_t)addr;
+    if (a >= (uintptr_t)m.dma_regs && a < (uintptr_t)m.dma_regs + MODEL_REG_BYTES) {
+        return dma_reg_read(a - (uintptr_t)m.dma_regs);
+    }
+    if (a >= (uintptr_t)m.gpio_regs && a < (uintptr_t)m.gpio_regs + MODEL_REG_BYTES) {
+        uint32_t offset = a - (uintptr_t)m.gpio_regs;
+        if (offset == GPIO_DATA) return gpio_state();
+        if (offset == GPIO2_DATA) return m.gpio_ctrl;
+        return m.gpio_regs[offset / 4];
+    }
+    fprintf(stderr, "DDR4 model: read from unmapped address %p\n", (void *)addr);
+    exit(1);
+}
+
+// MMIO Write (model backend)
+static void model_mmio_write(volatile void *addr, uint32_t value) {
+    uintptr_t a = (uintptr_t)addr;
+    if (a >= (uintptr_t)m.dma_regs && a < (uintptr_t)m.dma_regs + MODEL_REG_BYTES) {
+        dma_reg_write(a - (uintptr_t)m.dma_regs, value);
+        return;
+    }
+    if (a >= (uintptr_t)m.gpio_regs && a < (uintptr_t)m.gpio_regs + MODEL_REG_BYTES) {
+        uint32_t offset = a - (uintptr_t)m.gpio_regs;
+        if (offset == GPIO2_DATA) gpio_control(value);
+        else m.gpio_regs[offset / 4] = value;
+        return;
+    }
+    fprintf(stderr, "DDR4 model: write to unmapped address %p\n", (void *)addr);
+    exit(1);
+}
+
+// Cleanup (model backend)
+static void model_cleanup(void) {
+    if (m.dma_regs == NULL) return;
+    fprintf(stderr, "DDR4 model: %llu commands in %llu nCK, %llu rows stored, %llu timing violations\n",
+            (unsigned long long)m.n_commands, (unsigned long long)m.cycle * 4,
+            (unsigned long long)m.n_rows, (unsigned long long)m.n_violations);
+    for (int i = 0; i < MODEL_ROW_BUCKETS; i++) {
+        row_entry_t *e = m.rows[i];
+        while (e != NULL) {
+            row_entry_t *next = e->next;
+            free(e);
+            e = next;
+        }
+    }
+    beat_free(&m.wdata);
+    beat_free(&m.rdata);
+    free(m.words);
+    free(m.dma_regs);
+    free(m.gpio_regs);
+    free(udmabuf_vptr);
+    memset(&m, 0, sizeof(m));
+    dma0_vptr = NULL;
+    gpio_vptr = NULL;
+    udmabuf_vptr = NULL;
+}
+
+// Setup (model backend)
+// The register windows and the udmabuf are plain host memory; the udmabuf
+// gets a fake physical address that the DMA model translates back.
+static int model_setup(void) {
+    memset(&m, 0, sizeof(m));
+    m.dma_regs = calloc(1, MODEL_REG_BYTES);
+    m.gpio_regs = calloc(1, MODEL_REG_BYTES);
+    if (m.dma_regs == NULL || m.gpio_regs == NULL ||
+        posix_memalign(&udmabuf_vptr, 4096, MODEL_UDMABUF_SIZE) != 0) {
+        perror("DDR4 model: failed to allocate");
+        free(m.dma_regs);
+        free(m.gpio_regs);
+        m.dma_regs = NULL;
+        return -1;
+    }
+    memset(udmabuf_vptr, 0, MODEL_UDMABUF_SIZE);
+    udmabuf_size = MODEL_UDMABUF_SIZE;
+    udmabuf_phys_addr = MODEL_UDMABUF_PHYS;
+    dma0_vptr = m.dma_regs;
+    gpio_vptr = m.gpio_regs;
+    bridge_vptr = NULL;
+    m.t_col = NEVER;
+    for (int r = 0; r < MODEL_RANKS; r++) {
+        m.t_ref[r] = NEVER;
+        for (int b = 0; b < MODEL_BANKS; b++) {
+            m.banks[r][b].t_act = NEVER;
+            m.banks[r][b].t_pre = NEVER;
+        }
+    }
+    m.rdata.beats = malloc(MODEL_RDATA_DEPTH * sizeof(*m.rdata.beats));
+    m.rdata.last = malloc(MODEL_RDATA_DEPTH * sizeof(bool));
+    if (m.rdata.beats == NULL || m.rdata.last == NULL) {
+        perror("DDR4 model: failed to allocate");
+        model_cleanup();
+        return -1;
+    }
+    m.rdata.capacity = MODEL_RDATA_DEPTH;
+    return 0;
+}
+
+const backend_t model_backend = {
+    .name = "model",
+    .setup = model_setup,
+    .cleanup = model_cleanup,
+    .mmio_read = model_mmio_read,
+    .mmio_write = model_mmio_write,
+    .bridge_write = model_bridge_write,
+    .bridge_flush = model_bridge_flush,
+};
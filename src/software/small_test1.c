@@ -7,9 +7,13 @@
 #include "api.h"
 #include "utils.h"
 
+// Flip records printed per row
+#define MAX_FLIPS 64
+
 int main(int argc, char *argv[]) {
     uint32_t write_data_buf[16*128];
     uint32_t read_data_buf[16*128];
+    flip_t flips[MAX_FLIPS];
 
     if (argc != 2) {
         printf("Usage: %s <data>\n", argv[0]);
@@ -26,28 +30,38 @@ int main(int argc, char *argv[]) {
     uint32_t n_rows = 256;
     const uint32_t total_tests = n_ranks * n_banks * n_rows; // ranks * banks * rows
 
+    // Rows are queued ahead of verification to keep the DMA streaming
+    uint32_t n_slots = dma_queue_slots();
+    uint32_t n_issued = 0;
     uint32_t test_count = 0;
-    for (uint8_t rank_addr = 0; rank_addr < n_ranks; rank_addr++) {
-        for (uint8_t bank_addr = 0; bank_addr < n_banks; bank_addr++) {
-            for (uint32_t row_addr = 0; row_addr < n_rows; row_addr++) {
-                gen_data_pattern(write_data_buf, bank_addr, row_addr, rank_addr, seed);
-                uint32_t nck = 0;
-                nck += write_row_batch(write_data_buf, bank_addr, row_addr, rank_addr);
-                nck += read_row(read_data_buf, bank_addr, row_addr, rank_addr);
-                // Verify data
-                for (int i = 0; i < 128; i++) {
-                    for (int j = 0; j < 16; j++) {
-                        if (read_data_buf[i*16+j] != write_data_buf[i*16+j]) {
-                            printf("Error: Data mismatch at rank %u, bank %u, row %u: %08x != %08x\n", rank_addr, bank_addr, row_addr, read_data_buf[i*16+j], write_data_buf[i*16+j]);
-                            return -1;
-                        }
-                    }
-                }
-                test_count++;
-                printf("Test passed (%u / %u) - rank %u, bank %u, row %u\r", test_count, total_tests, rank_addr, bank_addr, row_addr);
-                fflush(stdout);
+    while (test_count < total_tests) {
+        // Queue write and read of the next rows
+        while (n_issued < total_tests && dma_recv_pending() < n_slots) {
+            uint32_t row_addr = n_issued % n_rows;
+            uint8_t bank_addr = (n_issued / n_rows) % n_banks;
+            uint8_t rank_addr = n_issued / (n_rows * n_banks);
+            gen_data_pattern(write_data_buf, bank_addr, row_addr, rank_addr, seed);
+            write_row_queue(write_data_buf, bank_addr, row_addr, rank_addr);
+            read_row_queue(bank_addr, row_addr, rank_addr);
+            n_issued++;
+        }
+        // Verify the oldest queued row
+        uint32_t row_addr = test_count % n_rows;
+        uint8_t bank_addr = (test_count / n_rows) % n_banks;
+        uint8_t rank_addr = test_count / (n_rows * n_banks);
+        read_row_complete(read_data_buf);
+        gen_data_pattern(write_data_buf, bank_addr, row_addr, rank_addr, seed);
+        uint32_t n_flips = compare_row(write_data_buf, read_data_buf, flips, MAX_FLIPS);
+        if (n_flips > 0) {
+            printf("Error: %u bit flips at rank %u, bank %u, row %u\n", n_flips, rank_addr, bank_addr, row_addr);
+            for (uint32_t k = 0; k < n_flips && k < MAX_FLIPS; k++) {
+                printf("  word %4u bit %2u: %s\n", flips[k].word, flips[k].bit, flips[k].dir ? "0->1" : "1->0");
             }
+            return -1;
         }
+        test_count++;
+        printf("Test passed (%u / %u) - rank %u, bank %u, row %u\r", test_count, total_tests, rank_addr, bank_addr, row_addr);
+        fflush(stdout);
     }
     printf("\n");
 
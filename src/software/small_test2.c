@@ -5,17 +5,82 @@
 #include <time.h>
 
 #include "api.h"
+#include "timing.h"
 #include "utils.h"
 
-int main(int argc, char *argv[]) {
+// Pipeline depth (rows in flight)
+#define PIPELINE_DEPTH 3
+// Flip records printed per row
+#define MAX_FLIPS 64
+// REFs collected per refresh burst (up to 8)
+#define REFRESH_POSTPONE 8
+
+// Verification context
+typedef struct {
+    uint32_t seed;
+    uint8_t pattern_id; // PATTERN_HOST: gen_data_pattern() via DMA
+    uint32_t test_count;
+    uint32_t total_tests;
+    uint32_t n_flips;
+} check_ctx_t;
+
+// Row generator
+static void gen_row(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, void *arg) {
+    gen_data_pattern(data_buf, bank_addr, row_addr, rank_addr, *(uint32_t *)arg);
+}
+
+// Row checker (reports every flipped bit and keeps going)
+static int check_row(const uint32_t *read_data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, void *arg) {
+    check_ctx_t *ctx = (check_ctx_t *)arg;
     uint32_t write_data_buf[16*128];
+    flip_t flips[MAX_FLIPS];
+    if (ctx->pattern_id == PATTERN_HOST) {
+        gen_data_pattern(write_data_buf, bank_addr, row_addr, rank_addr, ctx->seed);
+    } else {
+        gen_pattern(write_data_buf, ctx->pattern_id, bank_addr, row_addr, rank_addr, ctx->seed);
+    }
+    uint32_t n_flips = compare_row(write_data_buf, read_data_buf, flips, MAX_FLIPS);
+    if (n_flips > 0) {
+        printf("\nError: %u bit flips at rank %u, bank %u, row %u\n", n_flips, rank_addr, bank_addr, row_addr);
+        for (uint32_t k = 0; k < n_flips && k < MAX_FLIPS; k++) {
+            printf("  word %4u bit %2u: %s\n", flips[k].word, flips[k].bit, flips[k].dir ? "0->1" : "1->0");
+        }
+        ctx->n_flips += n_flips;
+    }
+    ctx->test_count++;
+    printf("Test %s (%u / %u) - rank %u, bank %u, row %u\r", n_flips ? "failed" : "passed", ctx->test_count, ctx->total_tests, rank_addr, bank_addr, row_addr);
+    fflush(stdout);
+    return 0;
+}
+
+// Row checker for compare reads (only mismatched columns reach the host)
+static int check_row_compare(const rd_compare_t *result, const uint32_t *mask_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, check_ctx_t *ctx) {
     uint32_t read_data_buf[16*128];
+    if (result->dropped > 0) {
+        printf("\nWarning: %u mismatch records dropped at rank %u, bank %u, row %u\n", result->dropped, rank_addr, bank_addr, row_addr);
+    }
+    if (result->flips == 0) {
+        ctx->test_count++;
+        printf("Test passed (%u / %u) - rank %u, bank %u, row %u\r", ctx->test_count, ctx->total_tests, rank_addr, bank_addr, row_addr);
+        fflush(stdout);
+        return 0;
+    }
+    // Rebuild the read data of the mismatched columns for the flip report
+    gen_pattern(read_data_buf, ctx->pattern_id, bank_addr, row_addr, rank_addr, ctx->seed);
+    for (int k = 0; k < 16*128; k++) {
+        read_data_buf[k] ^= mask_buf[k];
+    }
+    return check_row(read_data_buf, bank_addr, row_addr, rank_addr, ctx);
+}
+
+int main(int argc, char *argv[]) {
 
-    if (argc != 2) {
-        printf("Usage: %s <data>\n", argv[0]);
+    if (argc != 2 && argc != 3) {
+        printf("Usage: %s <data> [pattern id (generated in fabric)]\n", argv[0]);
         return -1;
     }
     uint32_t seed = strtol(argv[1], NULL, 16);
+    uint8_t pattern_id = (argc == 3) ? strtol(argv[2], NULL, 0) : PATTERN_HOST;
 
     // Parameters
     uint8_t n_ranks = 1;
@@ -26,48 +91,58 @@ int main(int argc, char *argv[]) {
     // Initialize hardware
     if (setup_hardware() != 0) return -1;
     printf("Hardware mapped successfully.\n\n");
+    refresh_stats_t refresh;
 
     // Write operations
     printf("Starting write operations...\n");
     struct timespec start, end;
+    perf_counters_t perf;
+    perf_clear();
+    // Refresh on tREFI deadlines instead of after every row
+    if (refresh_config(REFRESH_AUTO, n_ranks, REFRESH_POSTPONE) != 0) return -1;
     clock_gettime(CLOCK_MONOTONIC, &start);
-    for (uint8_t rank_addr = 0; rank_addr < n_ranks; rank_addr++) {
-        for (uint8_t bank_addr = 0; bank_addr < n_banks; bank_addr++) {
-            for (uint32_t row_addr = 0; row_addr < n_rows; row_addr++) {
-                gen_data_pattern(write_data_buf, bank_addr, row_addr, rank_addr, seed);
-                write_row_batch(write_data_buf, bank_addr, row_addr, rank_addr);
-                all_bank_refresh(rank_addr);
+    if (pattern_id == PATTERN_HOST) {
+        write_rows_pipelined(n_ranks, n_banks, n_rows, PIPELINE_DEPTH, false, gen_row, &seed);
+    } else {
+        // No write data leaves the host
+        for (uint8_t rank_addr = 0; rank_addr < n_ranks; rank_addr++) {
+            for (uint8_t bank_addr = 0; bank_addr < n_banks; bank_addr++) {
+                for (uint32_t row_addr = 0; row_addr < n_rows; row_addr++) {
+                    write_row_pattern(pattern_id, seed, bank_addr, row_addr, rank_addr);
+                }
             }
         }
     }
     clock_gettime(CLOCK_MONOTONIC, &end);
     printf("Write operations done.\n");
     double write_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
-    printf("Time taken: %f seconds, refresh interval: %fus (tREFI = 7.8us)\n\n", write_time, write_time/n_ranks/n_banks/n_rows*1e6);
+    refresh_stats(&refresh);
+    printf("Time taken: %f seconds, %llu REFs in %llu bursts (%llu late), refresh interval: %fus (tREFI = %.1fus)\n",
+           write_time, (unsigned long long)refresh.refs, (unsigned long long)refresh.bursts, (unsigned long long)refresh.late,
+           refresh.refs ? write_time / refresh.refs * n_ranks * 1e6 : 0.0, timing.tREFI * timing.tCK * 1e-3);
+    perf_snapshot(&perf);
+    perf_print(&perf);
+    printf("\n");
 
     // Read operations
     printf("Starting read operations...\n");
+    perf_clear();
+    // Refresh on tREFI deadlines instead of after every row
+    if (refresh_config(REFRESH_AUTO, n_ranks, REFRESH_POSTPONE) != 0) return -1;
     clock_gettime(CLOCK_MONOTONIC, &start);
-    uint32_t test_count = 0;
-    for (uint8_t rank_addr = 0; rank_addr < n_ranks; rank_addr++) {
-        for (uint8_t bank_addr = 0; bank_addr < n_banks; bank_addr++) {
-            for (uint32_t row_addr = 0; row_addr < n_rows; row_addr++) {
-                gen_data_pattern(write_data_buf, bank_addr, row_addr, rank_addr, seed);
-                uint32_t nck = 0;
-                nck += read_row(read_data_buf, bank_addr, row_addr, rank_addr);
-                // Verify data
-                for (int i = 0; i < 128; i++) {
-                    for (int j = 0; j < 16; j++) {
-                        if (read_data_buf[i*16+j] != write_data_buf[i*16+j]) {
-                            printf("Error: Data mismatch at rank %u, bank %u, row %u: %08x != %08x\n", rank_addr, bank_addr, row_addr, read_data_buf[i*16+j], write_data_buf[i*16+j]);
-                            return -1;
-                        }
-                    }
+    check_ctx_t ctx = { seed, pattern_id, 0, total_tests, 0 };
+    if (pattern_id == PATTERN_HOST) {
+        read_rows_pipelined(n_ranks, n_banks, n_rows, PIPELINE_DEPTH, false, check_row, &ctx);
+    } else {
+        // Compared in fabric, only mismatches are transferred
+        uint32_t mask_buf[16*128];
+        rd_compare_t result;
+        for (uint8_t rank_addr = 0; rank_addr < n_ranks; rank_addr++) {
+            for (uint8_t bank_addr = 0; bank_addr < n_banks; bank_addr++) {
+                for (uint32_t row_addr = 0; row_addr < n_rows; row_addr++) {
+                    read_row_compare(pattern_id, seed, bank_addr, row_addr, rank_addr, &result, mask_buf);
+                    check_row_compare(&result, mask_buf, bank_addr, row_addr, rank_addr, &ctx);
                 }
-                test_count++;
-                printf("Test passed (%u / %u) - rank %u, bank %u, row %u\r", test_count, total_tests, rank_addr, bank_addr, row_addr);
-                fflush(stdout);
-                all_bank_refresh(rank_addr);
             }
         }
     }
@@ -75,10 +150,20 @@ int main(int argc, char *argv[]) {
     clock_gettime(CLOCK_MONOTONIC, &end);
     printf("Read operations done.\n");
     double read_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
-    printf("Time taken: %f seconds, refresh interval: %fus (tREFI = 7.8us)\n\n", read_time, read_time/n_ranks/n_banks/n_rows*1e6);
+    refresh_stats(&refresh);
+    printf("Time taken: %f seconds, %llu REFs in %llu bursts (%llu late), refresh interval: %fus (tREFI = %.1fus)\n",
+           read_time, (unsigned long long)refresh.refs, (unsigned long long)refresh.bursts, (unsigned long long)refresh.late,
+           refresh.refs ? read_time / refresh.refs * n_ranks * 1e6 : 0.0, timing.tREFI * timing.tCK * 1e-3);
+    perf_snapshot(&perf);
+    perf_print(&perf);
+    printf("\n");
 
     // Cleanup
     cleanup_hardware();
 
+    if (ctx.n_flips > 0) {
+        printf("Total bit flips: %u\n", ctx.n_flips);
+        return -1;
+    }
     return 0;
 }
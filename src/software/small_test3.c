@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "api.h"
+#include "utils.h"
+#include "campaign.h"
+
+// Flip records printed per row
+#define MAX_FLIPS 64
+
+// Verification context (only used on the checker thread)
+typedef struct {
+    uint32_t seed;
+    uint32_t test_count;
+    uint32_t total_tests;
+    uint32_t n_flips;
+} check_ctx_t;
+
+// Row generator (generator thread)
+static void gen_row(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, void *arg) {
+    check_ctx_t *ctx = (check_ctx_t *)arg;
+    gen_data_pattern(data_buf, bank_addr, row_addr, rank_addr, ctx->seed);
+}
+
+// Row checker (checker thread, reports every flipped bit and keeps going)
+static int check_row(const uint32_t *read_data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, void *arg) {
+    check_ctx_t *ctx = (check_ctx_t *)arg;
+    uint32_t write_data_buf[16*128];
+    flip_t flips[MAX_FLIPS];
+    gen_data_pattern(write_data_buf, bank_addr, row_addr, rank_addr, ctx->seed);
+    uint32_t n_flips = compare_row(write_data_buf, read_data_buf, flips, MAX_FLIPS);
+    if (n_flips > 0) {
+        printf("\nError: %u bit flips at rank %u, bank %u, row %u\n", n_flips, rank_addr, bank_addr, row_addr);
+        for (uint32_t k = 0; k < n_flips && k < MAX_FLIPS; k++) {
+            printf("  word %4u bit %2u: %s\n", flips[k].word, flips[k].bit, flips[k].dir ? "0->1" : "1->0");
+        }
+        ctx->n_flips += n_flips;
+    }
+    ctx->test_count++;
+    printf("Test %s (%u / %u) - rank %u, bank %u, row %u\r", n_flips ? "failed" : "passed", ctx->test_count, ctx->total_tests, rank_addr, bank_addr, row_addr);
+    fflush(stdout);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+
+    if (argc != 2 && argc != 3) {
+        printf("Usage: %s <data> [rows per bank]\n", argv[0]);
+        return -1;
+    }
+
+    // Parameters
+    campaign_cfg_t cfg;
+    campaign_cfg_default(&cfg);
+    if (argc == 3) cfg.n_rows = strtoul(argv[2], NULL, 0);
+    check_ctx_t ctx = { strtoul(argv[1], NULL, 16), 0, cfg.n_ranks * cfg.n_banks * cfg.n_rows, 0 };
+    cfg.gen = gen_row;
+    cfg.check = check_row;
+    cfg.arg = &ctx;
+
+    // Initialize hardware
+    if (setup_hardware() != 0) return -1;
+    printf("Hardware mapped successfully.\n\n");
+
+    // Campaign
+    printf("Starting campaign: generator on core %d, submission on core %d, checker on core %d\n", cfg.gen_cpu, cfg.submit_cpu, cfg.check_cpu);
+    struct timespec start, end;
+    campaign_result_t result;
+    perf_counters_t perf;
+    perf_clear();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int ret = campaign_run(&cfg, &result);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("\nCampaign done.\n");
+    double campaign_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+    printf("Time taken: %f seconds, %f us per row\n", campaign_time, campaign_time / (result.rows_written + result.rows_read) * 1e6);
+    printf("Rows: %u written, %u read, %u checked\n", result.rows_written, result.rows_read, result.rows_checked);
+    printf("Stalls: generator %llu, submission %llu, checker %llu\n",
+           (unsigned long long)result.gen_stalls, (unsigned long long)result.submit_stalls, (unsigned long long)result.check_stalls);
+    perf_snapshot(&perf);
+    perf_print(&perf);
+    printf("\n");
+
+    // Cleanup
+    cleanup_hardware();
+
+    if (ret != 0) return -1;
+    if (ctx.n_flips > 0) {
+        printf("Total bit flips: %u\n", ctx.n_flips);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,567 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+
+#include "api.h"
+#include "backend.h"
+#include "timing.h"
+
+#define TIMING_BANKS       16
+#define TIMING_GROUPS      4
+#define TIMING_RANKS       2
+#define TIMING_MAX_REPORTS 16            // Violations printed per check
+#define BURST_NCK          4             // BL8 data burst
+#define RTRS_NCK           2             // Data bus gap when the rank changes
+#define STRICT_FLAG        (1u << 31)
+#define NEVER              (-(1ll << 40)) // Time of a command that never happened
+
+// Command Opcodes ([2:0] of the command word)
+enum { CMD_NOP, CMD_PRE, CMD_ACT, CMD_RD, CMD_WR, CMD_REF, CMD_ZQ, CMD_WAIT };
+
+// Timing Parameters (defaults: the DIMM at tCK = 1.5ns)
+// Each value is the larger of its ns part, rounded up to whole cycles of
+// the profile's tCK, and its nCK part.
+typedef struct {
+    const char *key;
+    size_t offset;
+    double ns;
+    uint32_t nck;
+    bool max;  // Upper bound (tREFI): the ns part is rounded down
+} timing_param_t;
+
+#define TIMING_PARAM(f, ns, nck) { #f, offsetof(timing_profile_t, f), ns, nck, false }
+static const timing_param_t timing_params[] = {
+    TIMING_PARAM(tRCD,   14.16,   0),
+    TIMING_PARAM(tRP,    14.16,   0),
+    TIMING_PARAM(tRAS,   32.0,    0),
+    TIMING_PARAM(tRC,    46.16,   0),
+    TIMING_PARAM(tRRD_S, 3.3,     4),
+    TIMING_PARAM(tRRD_L, 6.4,     4),
+    TIMING_PARAM(tFAW,   20.0,    0),   // 1KB page
+    TIMING_PARAM(tCCD_S, 0,       4),   // BL8 burst on the data bus
+    TIMING_PARAM(tCCD_L, 5.0,     4),   // 6 * 0.833ns
+    TIMING_PARAM(tCL,    13.75,   0),
+    TIMING_PARAM(tCWL,   0,       9),
+    TIMING_PARAM(tWR,    15.0,    0),
+    TIMING_PARAM(tRTP,   7.5,     4),
+    TIMING_PARAM(tWTR_S, 2.5,     2),
+    TIMING_PARAM(tWTR_L, 7.5,     4),
+    TIMING_PARAM(tRFC,   350.693, 0),   // 421 * 0.833ns (8Gb)
+    TIMING_PARAM(tZQCS,  0,       128),
+    { "tREFI", offsetof(timing_profile_t, tREFI), 7800.0, 0, true },
+};
+#define TIMING_N_PARAMS    (sizeof(timing_params) / sizeof(timing_params[0]))
+#define TIMING_DEFAULT_TCK 1.5
+
+// Timing Value Parse ("<ns>ns", "<n>nCK" or both; a bare number is ns)
+static int timing_parse_value(char *value, double *ns, uint32_t *nck) {
+    *ns = 0;
+    *nck = 0;
+    int n_parts = 0;
+    for (char *tok = strtok(value, " \t,"); tok != NULL; tok = strtok(NULL, " \t,")) {
+        char *unit;
+        double v = strtod(tok, &unit);
+        if (unit == tok || v < 0) return -1;
+        if (*unit == '\0' || strcmp(unit, "ns") == 0) {
+            *ns = v;
+        } else if (strcmp(unit, "nCK") == 0 && v == (uint32_t)v) {
+            *nck = (uint32_t)v;
+        } else {
+            return -1;
+        }
+        n_parts++;
+    }
+    return n_parts > 0 ? 0 : -1;
+}
+
+// Timing Profile Load
+// Reads "key = value" lines ('#' starts a comment): "name" labels the
+// profile, "tCK" is the clock period in ns and every other key is a timing
+// parameter (see timing_parse_value). Parameters not in the file keep their
+// default ns/nCK values, derived against the file's tCK. A NULL path loads
+// the default profile.
+int timing_load(const char *path, timing_profile_t *tp) {
+    double ns[TIMING_N_PARAMS];
+    uint32_t nck[TIMING_N_PARAMS];
+    for (uint32_t i = 0; i < TIMING_N_PARAMS; i++) {
+        ns[i] = timing_params[i].ns;
+        nck[i] = timing_params[i].nck;
+    }
+    memset(tp, 0, sizeof(*tp));
+    snprintf(tp->name, sizeof(tp->name), "default");
+    tp->tCK = TIMING_DEFAULT_TCK;
+
+    if (path != NULL) {
+        FILE *f = fopen(path, "r");
+        if (f == NULL) {
+            perror("Failed to open timing profile");
+            return -1;
+        }
+        char line[256];
+        uint32_t line_no = 0;
+        while (fgets(line, sizeof(line), f) != NULL) {
+            line_no++;
+            char key[32], value[128];
+            char *comment = strchr(line, '#');
+            if (comment != NULL) *comment = '\0';
+            if (sscanf(line, " %31s", key) != 1) continue; // Blank line
+            int ret = -1;
+            if (sscanf(line, " %31[^= \t] = %127[^\n]", key, value) == 2) {
+                if (strcmp(key, "name") == 0) {
+                    ret = sscanf(value, "%31s", tp->name) == 1 ? 0 : -1;
+                } else if (strcmp(key, "tCK") == 0) {
+                    char *end;
+                    tp->tCK = strtod(value, &end);
+                    ret = (end != value && tp->tCK > 0) ? 0 : -1;
+                } else {
+                    for (uint32_t i = 0; i < TIMING_N_PARAMS; i++) {
+                        if (strcmp(key, timing_params[i].key) == 0) {
+                            ret = timing_parse_value(value, &ns[i], &nck[i]);
+                            break;
+                        }
+                    }
+                }
+            }
+            if (ret != 0) {
+                fprintf(stderr, "%s:%u: Invalid timing profile line: %s\n", path, line_no, key);
+                fclose(f);
+                return -1;
+            }
+        }
+        fclose(f);
+    }
+
+    // Derive cycle counts (the small margin keeps exact multiples of tCK
+    // from rounding a whole cycle the wrong way)
+    for (uint32_t i = 0; i < TIMING_N_PARAMS; i++) {
+        uint32_t n = timing_params[i].max ? (uint32_t)floor(ns[i] / tp->tCK + 1e-6) : (uint32_t)ceil(ns[i] / tp->tCK - 1e-6);
+        if (n < nck[i]) n = nck[i];
+        *(uint32_t *)((uint8_t *)tp + timing_params[i].offset) = n;
+    }
+    return 0;
+}
+
+// Timing Profile Print
+void timing_print(const timing_profile_t *tp) {
+    printf("Timing profile %s (tCK %.3fns):", tp->name, tp->tCK);
+    for (uint32_t i = 0; i < TIMING_N_PARAMS; i++) {
+        printf(" %s %u", timing_params[i].key, *(const uint32_t *)((const uint8_t *)tp + timing_params[i].offset));
+    }
+    printf("\n");
+}
+
+// Bank and Timing State of a Rank (per bank, per bank group and rank wide)
+typedef struct {
+    bool open[TIMING_BANKS];
+    int64_t t_act[TIMING_BANKS];
+    int64_t t_pre[TIMING_BANKS];
+    int64_t t_rd[TIMING_BANKS];
+    int64_t t_wr[TIMING_BANKS];
+    int64_t t_act_bg[TIMING_GROUPS];
+    int64_t t_rd_bg[TIMING_GROUPS];
+    int64_t t_wr_bg[TIMING_GROUPS];
+    int64_t t_col_bg[TIMING_GROUPS];
+    int64_t faw[4];    // Last four ACTs, the oldest at faw_head
+    uint32_t faw_head;
+    int64_t t_ref;
+    int64_t t_zq;
+} timing_rank_t;
+
+// Timing State (ranks share only the command and data buses)
+typedef struct {
+    timing_rank_t rank[TIMING_RANKS];
+} timing_state_t;
+
+// Command Word Fields
+static uint32_t cmd_op(uint32_t slot) { return slot & 0x7; }
+static uint32_t cmd_bank(uint32_t slot) { return (slot >> 3) & 0xF; }
+static uint32_t cmd_rank(uint32_t slot) { return (slot >> 24) & (TIMING_RANKS - 1); }
+static bool cmd_pre_all(uint32_t slot) { return (slot >> 7) & 1; }
+static bool cmd_is_cfg(uint32_t slot) { return cmd_op(slot) == CMD_WAIT && ((slot >> 30) & 1); }
+static uint32_t cmd_wait(uint32_t slot) { return cmd_op(slot) == CMD_WAIT && !cmd_is_cfg(slot) ? (slot >> 3) & WAIT_MAX_COUNT : 0; }
+static bool cmd_is_command(uint32_t slot) { return cmd_op(slot) != CMD_NOP && cmd_op(slot) != CMD_WAIT; }
+static bool cmd_is_host_wr(uint32_t slot) { return cmd_op(slot) == CMD_WR && ((slot >> 17) & 0x7) == PATTERN_HOST; }
+
+// State Initialize (all banks closed, no history)
+static void timing_state_init(timing_state_t *st) {
+    memset(st, 0, sizeof(*st));
+    for (int k = 0; k < TIMING_RANKS; k++) {
+        timing_rank_t *r = &st->rank[k];
+        for (int b = 0; b < TIMING_BANKS; b++) {
+            r->t_act[b] = r->t_pre[b] = r->t_rd[b] = r->t_wr[b] = NEVER;
+        }
+        for (int g = 0; g < TIMING_GROUPS; g++) {
+            r->t_act_bg[g] = r->t_rd_bg[g] = r->t_wr_bg[g] = r->t_col_bg[g] = NEVER;
+        }
+        for (int i = 0; i < 4; i++) r->faw[i] = NEVER;
+        r->t_ref = NEVER;
+        r->t_zq = NEVER;
+    }
+}
+
+// Constraint (the command may not issue before t + n)
+static void bound(int64_t *e, const char **name, int64_t t, int64_t n, const char *what) {
+    if (t + n > *e) {
+        *e = t + n;
+        *name = what;
+    }
+}
+
+// Earliest DRAM cycle a command may issue at, and the binding constraint
+// tCCD_L is never taken shorter than tCCD_S (the data burst). A RD/WR after
+// a column command to another rank only waits for the data bus (burst plus
+// RTRS_NCK, or the read/write turnaround).
+static int64_t timing_earliest(const timing_state_t *st, const timing_profile_t *tp, uint32_t slot, const char **name) {
+    const timing_rank_t *r = &st->rank[cmd_rank(slot)];
+    uint32_t bank = cmd_bank(slot);
+    uint32_t bg = bank >> 2;
+    int64_t ccd_l = tp->tCCD_L > tp->tCCD_S ? tp->tCCD_L : tp->tCCD_S;
+    int64_t e = NEVER;
+    *name = NULL;
+    switch (cmd_op(slot)) {
+        case CMD_ACT:
+            bound(&e, name, r->t_pre[bank], tp->tRP, "tRP");
+            bound(&e, name, r->t_act[bank], tp->tRC, "tRC");
+            for (uint32_t g = 0; g < TIMING_GROUPS; g++) {
+                bound(&e, name, r->t_act_bg[g], g == bg ? tp->tRRD_L : tp->tRRD_S, g == bg ? "tRRD_L" : "tRRD_S");
+            }
+            bound(&e, name, r->faw[r->faw_head], tp->tFAW, "tFAW");
+            bound(&e, name, r->t_ref, tp->tRFC, "tRFC");
+            break;
+        case CMD_RD:
+            bound(&e, name, r->t_act[bank], tp->tRCD, "tRCD");
+            for (uint32_t g = 0; g < TIMING_GROUPS; g++) {
+                bound(&e, name, r->t_col_bg[g], g == bg ? ccd_l : tp->tCCD_S, g == bg ? "tCCD_L" : "tCCD_S");
+                bound(&e, name, r->t_wr_bg[g], tp->tCWL + BURST_NCK + (g == bg ? tp->tWTR_L : tp->tWTR_S), g == bg ? "tWTR_L" : "tWTR_S");
+            }
+            for (uint32_t k = 0; k < TIMING_RANKS; k++) {
+                const timing_rank_t *o = &st->rank[k];
+                if (o == r) continue;
+                for (uint32_t g = 0; g < TIMING_GROUPS; g++) {
+                    bound(&e, name, o->t_col_bg[g], tp->tCCD_S + RTRS_NCK, "tRTRS");
+                    bound(&e, name, o->t_wr_bg[g], (int64_t)tp->tCWL + BURST_NCK + RTRS_NCK - tp->tCL, "tRTRS");
+                }
+            }
+            break;
+        case CMD_WR:
+            bound(&e, name, r->t_act[bank], tp->tRCD, "tRCD");
+            for (uint32_t g = 0; g < TIMING_GROUPS; g++) {
+                bound(&e, name, r->t_col_bg[g], g == bg ? ccd_l : tp->tCCD_S, g == bg ? "tCCD_L" : "tCCD_S");
+            }
+            for (uint32_t k = 0; k < TIMING_RANKS; k++) {
+                const timing_rank_t *o = &st->rank[k];
+                for (uint32_t g = 0; g < TIMING_GROUPS; g++) {
+                    if (o != r) bound(&e, name, o->t_col_bg[g], tp->tCCD_S + RTRS_NCK, "tRTRS");
+                    bound(&e, name, o->t_rd_bg[g], (int64_t)tp->tCL + BURST_NCK + 2 - tp->tCWL, "tRTW");
+                }
+            }
+            break;
+        case CMD_PRE:
+            for (uint32_t b = 0; b < TIMING_BANKS; b++) {
+                if ((b != bank && !cmd_pre_all(slot)) || !r->open[b]) continue;
+                bound(&e, name, r->t_act[b], tp->tRAS, "tRAS");
+                bound(&e, name, r->t_rd[b], tp->tRTP, "tRTP");
+                bound(&e, name, r->t_wr[b], tp->tCWL + BURST_NCK + tp->tWR, "tWR");
+            }
+            break;
+        case CMD_REF:
+        case CMD_ZQ:
+            for (uint32_t b = 0; b < TIMING_BANKS; b++) {
+                bound(&e, name, r->t_pre[b], tp->tRP, "tRP");
+            }
+            bound(&e, name, r->t_ref, tp->tRFC, "tRFC");
+            break;
+        default:
+            return NEVER;
+    }
+    bound(&e, name, r->t_zq, tp->tZQCS, "tZQCS");
+    return e;
+}
+
+// Bank State Check (NULL when the command fits the bank state)
+static const char *timing_state_error(const timing_state_t *st, uint32_t slot) {
+    const timing_rank_t *r = &st->rank[cmd_rank(slot)];
+    uint32_t bank = cmd_bank(slot);
+    switch (cmd_op(slot)) {
+        case CMD_ACT:
+            return r->open[bank] ? "ACT to open bank" : NULL;
+        case CMD_RD:
+            return r->open[bank] ? NULL : "RD to closed bank";
+        case CMD_WR:
+            return r->open[bank] ? NULL : "WR to closed bank";
+        case CMD_REF:
+        case CMD_ZQ:
+            for (uint32_t b = 0; b < TIMING_BANKS; b++) {
+                if (r->open[b]) return cmd_op(slot) == CMD_REF ? "REF with open bank" : "ZQ with open bank";
+            }
+            return NULL;
+        default:
+            return NULL;
+    }
+}
+
+// State Update (command issued at DRAM cycle T)
+static void timing_apply(timing_state_t *st, uint32_t slot, int64_t T) {
+    timing_rank_t *r = &st->rank[cmd_rank(slot)];
+    uint32_t bank = cmd_bank(slot);
+    uint32_t bg = bank >> 2;
+    switch (cmd_op(slot)) {
+        case CMD_ACT:
+            r->open[bank] = true;
+            r->t_act[bank] = T;
+            r->t_act_bg[bg] = T;
+            r->faw[r->faw_head] = T;
+            r->faw_head = (r->faw_head + 1) % 4;
+            break;
+        case CMD_RD:
+            r->t_rd[bank] = r->t_rd_bg[bg] = r->t_col_bg[bg] = T;
+            break;
+        case CMD_WR:
+            r->t_wr[bank] = r->t_wr_bg[bg] = r->t_col_bg[bg] = T;
+            break;
+        case CMD_PRE:
+            for (uint32_t b = 0; b < TIMING_BANKS; b++) {
+                if (b != bank && !cmd_pre_all(slot)) continue;
+                r->open[b] = false; // tRP also runs after a PRE to a closed bank
+                r->t_pre[b] = T;
+            }
+            break;
+        case CMD_REF:
+            r->t_ref = T;
+            break;
+        case CMD_ZQ:
+            r->t_zq = T;
+            break;
+        default:
+            break;
+    }
+}
+
+// Settled Cycle (no constraint from the commands so far reaches past it,
+// so any command may follow)
+static int64_t timing_settled(const timing_state_t *st, const timing_profile_t *tp) {
+    const char *name;
+    int64_t e = 0;
+    for (uint32_t k = 0; k < TIMING_RANKS; k++) {
+        const timing_rank_t *r = &st->rank[k];
+        for (uint32_t b = 0; b < TIMING_BANKS; b++) {
+            bound(&e, &name, r->t_act[b], tp->tRC > tp->tRAS ? tp->tRC : tp->tRAS, "tRC");
+            bound(&e, &name, r->t_pre[b], tp->tRP, "tRP");
+            bound(&e, &name, r->t_rd[b], tp->tRTP, "tRTP");
+            bound(&e, &name, r->t_wr[b], tp->tCWL + BURST_NCK + tp->tWR, "tWR");
+        }
+        for (uint32_t g = 0; g < TIMING_GROUPS; g++) {
+            bound(&e, &name, r->t_act_bg[g], tp->tRRD_L, "tRRD_L");
+            bound(&e, &name, r->t_col_bg[g], tp->tCCD_L > tp->tCCD_S ? tp->tCCD_L : tp->tCCD_S, "tCCD_L");
+            bound(&e, &name, r->t_col_bg[g], tp->tCCD_S + RTRS_NCK, "tRTRS");
+            bound(&e, &name, r->t_rd_bg[g], (int64_t)tp->tCL + BURST_NCK + 2 - tp->tCWL, "tRTW");
+            bound(&e, &name, r->t_wr_bg[g], tp->tCWL + BURST_NCK + tp->tWTR_L, "tWTR_L");
+        }
+        for (int i = 0; i < 4; i++) bound(&e, &name, r->faw[i], tp->tFAW, "tFAW");
+        bound(&e, &name, r->t_ref, tp->tRFC, "tRFC");
+        bound(&e, &name, r->t_zq, tp->tZQCS, "tZQCS");
+    }
+    return e;
+}
+
+// Timing Check
+// Walks the stream the way the fabric issues it (bridge framing: a slot
+// without the strict flag ends the 128-bit word, slot s of the word issues
+// at DRAM cycle 4 * cycle + s, WAIT holds the next word back) and checks
+// every command against the profile and the bank states. Commands inside a
+// strict packet are counted as deliberate and not printed. Without a packet
+// map (recorded streams) a packet is where the slot or the one before it
+// has the strict flag; compacted streams pass the map from timing_compact,
+// as the strict flags it sets to pack words are not packets. Returns -1 if
+// any other command violates the timing.
+int timing_check(const timing_profile_t *tp, const uint32_t *words, uint32_t n_words, const uint32_t *packet_map, timing_report_t *report) {
+    timing_state_t st;
+    timing_state_init(&st);
+    memset(report, 0, sizeof(*report));
+    uint64_t cycle = 0;
+    uint64_t wait_total = 0;
+    uint32_t s = 0;
+    bool prev_strict = false;
+    for (uint32_t i = 0; i < n_words; i++) {
+        uint32_t w = words[i];
+        int64_t T = (int64_t)cycle * 4 + s;
+        if (cmd_is_command(w)) {
+            const char *name;
+            int64_t e = timing_earliest(&st, tp, w, &name);
+            const char *err = timing_state_error(&st, w);
+            report->n_commands++;
+            if (err != NULL || T < e) {
+                bool deliberate = packet_map != NULL ? (packet_map[i / 32] >> (i % 32)) & 1
+                                                     : prev_strict || (w & STRICT_FLAG);
+                report->n_violations++;
+                if (deliberate) {
+                    report->n_deliberate++;
+                } else if (report->n_violations - report->n_deliberate <= TIMING_MAX_REPORTS) {
+                    if (err != NULL) {
+                        fprintf(stderr, "Timing violation: %s at nCK %lld, rank %u bank %u (word %u)\n", err, (long long)T, cmd_rank(w), cmd_bank(w), i);
+                    } else {
+                        fprintf(stderr, "Timing violation: %s at nCK %lld, rank %u bank %u (word %u): %lld nCK early\n",
+                                name, (long long)T, cmd_rank(w), cmd_bank(w), i, (long long)(e - T));
+                    }
+                }
+            }
+            timing_apply(&st, w, T);
+        }
+        wait_total += cmd_wait(w);
+        prev_strict = w & STRICT_FLAG;
+        if (++s == 4 || !prev_strict) {
+            cycle += 1 + wait_total;
+            wait_total = 0;
+            s = 0;
+        }
+    }
+    if (s > 0) cycle += 1 + wait_total;
+    report->nck = cycle * 4;
+    return report->n_violations > report->n_deliberate ? -1 : 0;
+}
+
+// Compactor Output
+// Slots are appended one at a time; a slot joins the word being built by
+// setting the strict flag of the slot before it.
+typedef struct {
+    cmd_buf_t *out;
+    uint32_t *packet_map; // Words copied from strict packets (or NULL)
+    uint64_t cycle;   // Fabric cycle of the word being built
+    uint32_t n_slots; // Slots in that word
+    uint64_t wait;    // WAIT cycles in that word
+    bool host_wr;     // That word has a host WR (one write data beat per word)
+    bool full;        // The output buffer ran out
+} emit_t;
+
+// End the word being built
+static void emit_close(emit_t *em) {
+    if (em->n_slots == 0) return;
+    em->cycle += 1 + em->wait;
+    em->n_slots = 0;
+    em->wait = 0;
+    em->host_wr = false;
+}
+
+// Append a slot (strict: copied as is, the word ends where the flag is clear)
+static void emit_slot(emit_t *em, uint32_t slot, bool strict) {
+    cmd_buf_t *out = em->out;
+    if (out->n_words == out->capacity) {
+        em->full = true;
+        return;
+    }
+    if (!strict) {
+        if (em->n_slots > 0) out->words[out->n_words - 1] |= STRICT_FLAG;
+        slot &= ~STRICT_FLAG;
+    } else if (em->packet_map != NULL) {
+        em->packet_map[out->n_words / 32] |= 1u << (out->n_words % 32);
+    }
+    out->words[out->n_words++] = slot;
+    em->n_slots++;
+    em->wait += cmd_wait(slot);
+    if (cmd_is_host_wr(slot)) em->host_wr = true;
+    // Appended slots leave the word open (the next one flags them)
+    if (em->n_slots == 4 || (strict && !(slot & STRICT_FLAG))) emit_close(em);
+}
+
+// Advance to DRAM cycle E (NOPs within the word, a WAIT across words) and
+// return the cycle of the next slot
+static int64_t emit_advance(emit_t *em, int64_t E) {
+    for (;;) {
+        int64_t T = (int64_t)em->cycle * 4 + em->n_slots;
+        if (T >= E || em->full) return T;
+        uint64_t c = E / 4;
+        if (c == em->cycle) {
+            emit_slot(em, CMD_WAIT, false); // NOP (WAIT 0)
+            continue;
+        }
+        uint64_t k = c - em->cycle - 1;
+        if (k > WAIT_MAX_COUNT) k = WAIT_MAX_COUNT;
+        if (k > 0 || em->n_slots == 0) emit_slot(em, CMD_WAIT | (uint32_t)(k << 3), false);
+        emit_close(em);
+    }
+}
+
+// Strict Packet (slots up to and including the first one without the
+// strict flag), copied verbatim from a word boundary. It starts once each of
+// its commands is legal against the commands before it; the spacing inside
+// is kept as written. Returns the number of slots.
+static uint32_t emit_packet(emit_t *em, timing_state_t *st, const timing_profile_t *tp, const uint32_t *words, uint32_t n_words) {
+    const char *name;
+    uint32_t n = 0;
+    int64_t start = 0;
+    uint64_t cycle = 0, wait = 0;
+    uint32_t s = 0;
+    // Packet length and earliest start (offsets from the first slot)
+    while (n < n_words) {
+        uint32_t w = words[n++];
+        if (cmd_is_command(w)) {
+            int64_t need = timing_earliest(st, tp, w, &name) - ((int64_t)cycle * 4 + s);
+            if (need > start) start = need;
+        }
+        wait += cmd_wait(w);
+        if (++s == 4 || !(w & STRICT_FLAG)) {
+            cycle += 1 + wait;
+            wait = 0;
+            s = 0;
+        }
+        if (!(w & STRICT_FLAG)) break;
+    }
+    emit_close(em);
+    emit_advance(em, (start + 3) / 4 * 4);
+    for (uint32_t i = 0; i < n; i++) {
+        int64_t T = (int64_t)em->cycle * 4 + em->n_slots;
+        if (cmd_is_command(words[i])) timing_apply(st, words[i], T);
+        emit_slot(em, words[i], true);
+    }
+    return n;
+}
+
+// NOP Compactor
+// Rewrites a stream so that every command issues at its earliest legal
+// cycle under the profile (as timing_check sees it): recorded NOP/WAIT
+// padding is dropped, commands are packed into 128-bit words with NOPs
+// between them and WAITs across words. CFG slots keep their place in the
+// order. Strict packets are kept verbatim (see emit_packet), so violations
+// inside them stay. The stream ends settled, so compacted buffers can be
+// submitted back to back. out->nck is the DRAM cycles of the result.
+// packet_map (TIMING_MAP_WORDS(out->capacity) words, or NULL) marks the
+// words of those packets for timing_check.
+int timing_compact(const timing_profile_t *tp, const cmd_buf_t *in, cmd_buf_t *out, uint32_t *packet_map) {
+    timing_state_t st;
+    timing_state_init(&st);
+    emit_t em = { out, packet_map, 0, 0, 0, false, false };
+    cmd_buf_reset(out);
+    if (packet_map != NULL) memset(packet_map, 0, TIMING_MAP_WORDS(out->capacity) * sizeof(uint32_t));
+    const char *name;
+    uint32_t i = 0;
+    while (i < in->n_words && !em.full) {
+        uint32_t w = in->words[i];
+        if (w & STRICT_FLAG) {
+            i += emit_packet(&em, &st, tp, in->words + i, in->n_words - i);
+            continue;
+        }
+        i++;
+        if (cmd_is_cfg(w)) {
+            emit_slot(&em, w, false);
+        } else if (cmd_is_command(w)) {
+            if (cmd_is_host_wr(w) && em.host_wr) emit_close(&em);
+            int64_t T = emit_advance(&em, timing_earliest(&st, tp, w, &name));
+            emit_slot(&em, w, false);
+            timing_apply(&st, w, T);
+        }
+        // NOP/WAIT padding is dropped
+    }
+    emit_advance(&em, timing_settled(&st, tp));
+    emit_close(&em);
+    if (em.full) {
+        fprintf(stderr, "Compacted stream does not fit in command buffer: %u words\n", out->capacity);
+        cmd_buf_reset(out);
+        return -1;
+    }
+    out->nck = em.cycle * 4;
+    return 0;
+}
@@ -0,0 +1,57 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "api.h"
+
+// DDR4 Timing Profile (all in DRAM cycles)
+// Write data ends tCWL + 4 cycles after the WR (BL8), which is where tWR and
+// tWTR start; a WR after a RD waits tCL + 4 + 2 - tCWL (bus turnaround).
+typedef struct {
+    char name[32];
+    double tCK;      // Clock period (ns)
+    uint32_t tRCD;   // ACT -> RD/WR (same bank)
+    uint32_t tRP;    // PRE -> ACT/REF (same bank)
+    uint32_t tRAS;   // ACT -> PRE (same bank)
+    uint32_t tRC;    // ACT -> ACT (same bank)
+    uint32_t tRRD_S; // ACT -> ACT (different bank group)
+    uint32_t tRRD_L; // ACT -> ACT (same bank group)
+    uint32_t tFAW;   // Four ACT window
+    uint32_t tCCD_S; // RD/WR -> RD/WR (different bank group)
+    uint32_t tCCD_L; // RD/WR -> RD/WR (same bank group)
+    uint32_t tCL;    // RD -> read data
+    uint32_t tCWL;   // WR -> write data
+    uint32_t tWR;    // End of write data -> PRE (same bank)
+    uint32_t tRTP;   // RD -> PRE (same bank)
+    uint32_t tWTR_S; // End of write data -> RD (different bank group)
+    uint32_t tWTR_L; // End of write data -> RD (same bank group)
+    uint32_t tRFC;   // REF -> ACT/REF
+    uint32_t tZQCS;  // ZQ short -> any command
+    uint32_t tREFI;  // Average REF interval (upper bound)
+} timing_profile_t;
+
+// Active profile, loaded by setup_hardware() from $SDDT_TIMING (default
+// profile if unset); the row helpers and the DDR4 model use it
+extern timing_profile_t timing;
+
+int timing_load(const char *path, timing_profile_t *tp);
+void timing_print(const timing_profile_t *tp);
+
+// Timing Check Report
+typedef struct {
+    uint64_t n_commands;   // Commands (not NOP/WAIT/CFG)
+    uint64_t n_violations; // Commands issued too early or to a bank in the wrong state
+    uint64_t n_deliberate; // Of those, inside strict packets (kept on purpose)
+    uint64_t nck;          // DRAM cycles of the stream as the fabric issues it
+} timing_report_t;
+
+// Packet Map: one bit per word (word i is bit i % 32 of map[i / 32]), set
+// for the words timing_compact copied from strict packets of its input
+#define TIMING_MAP_WORDS(n_words) (((n_words) + 31) / 32)
+
+int timing_check(const timing_profile_t *tp, const uint32_t *words, uint32_t n_words, const uint32_t *packet_map, timing_report_t *report);
+int timing_compact(const timing_profile_t *tp, const cmd_buf_t *in, cmd_buf_t *out, uint32_t *packet_map);
+
+#endif
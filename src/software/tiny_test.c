@@ -5,6 +5,7 @@
 #include <time.h>
 
 #include "api.h"
+#include "timing.h"
 #include "utils.h"
 
 int main(int argc, char *argv[]) {
@@ -30,6 +31,7 @@ int main(int argc, char *argv[]) {
     /*** Start operations ***/
     printf("Starting operations...\n");
     struct timespec start, end;
+    issue_mark();
     clock_gettime(CLOCK_MONOTONIC, &start);
 
     uint32_t nck = 0;
@@ -52,10 +54,17 @@ int main(int argc, char *argv[]) {
 
     double latency_s = (end.tv_sec - start.tv_sec) + 
                         (end.tv_nsec - start.tv_nsec) * 1e-9;
-    double ideal_latency_s = nck * 1.5e-9;
+    double ideal_latency_s = nck * timing.tCK * 1e-9;
     printf("Time taken: %f seconds\n", latency_s);
     printf("Overhead: %fx slower than ideal\n", latency_s / ideal_latency_s);
 
+    // DRAM-side issue density (hardware issue window)
+    perf_counters_t perf;
+    cmd_drain();
+    perf_snapshot(&perf);
+    uint64_t issued_nck = perf_issue_nck(&perf);
+    printf("Issued over %llu nCK: %fx the ideal %u nCK\n", (unsigned long long)issued_nck, (double)issued_nck / nck, nck);
+
     // Verify data
     for (int i = 0; i < 128; i++) {
         for (int j = 0; j < 16; j++) {
@@ -1,6 +1,33 @@
 #include <stdint.h>
+#include <string.h>
 
-void gen_data_pattern(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, uint32_t seed) {
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "utils.h"
+
+#define FNV_OFFSET 2166136261u // FNV offset basis
+#define FNV_PRIME  16777619u   // FNV prime
+
+// Row Hash Prefix (rank, bank, row, seed steps, same for the whole row)
+static uint32_t row_hash_prefix(uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, uint32_t seed) {
+    uint32_t hash = FNV_OFFSET;
+    hash ^= rank_addr;
+    hash *= FNV_PRIME;
+    hash ^= bank_addr;
+    hash *= FNV_PRIME;
+    hash ^= row_addr;
+    hash *= FNV_PRIME;
+    hash ^= seed;
+    hash *= FNV_PRIME;
+    return hash;
+}
+
+// Generate Data Pattern (Scalar Reference)
+void gen_data_pattern_scalar(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, uint32_t seed) {
     for (int i = 0; i < 128; i++) {
         for (int j = 0; j < 16; j++) {
             // Hash function: FNV-1a inspired hash
@@ -21,3 +48,189 @@ void gen_data_pattern(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr,
         }
     }
 }
+
+#if defined(__ARM_NEON)
+// Generate Data Pattern (NEON)
+// The 16 words of a column are computed as 4 vectors of 4 lanes (j).
+static void gen_data_pattern_neon(uint32_t *data_buf, uint32_t prefix) {
+    const uint32_t lanes[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    const uint32x4_t prime = vdupq_n_u32(FNV_PRIME);
+    const uint32x4_t j0 = vld1q_u32(lanes + 0);
+    const uint32x4_t j1 = vld1q_u32(lanes + 4);
+    const uint32x4_t j2 = vld1q_u32(lanes + 8);
+    const uint32x4_t j3 = vld1q_u32(lanes + 12);
+    for (uint32_t i = 0; i < 128; i++) {
+        uint32x4_t h = vdupq_n_u32((prefix ^ i) * FNV_PRIME);
+        vst1q_u32(data_buf + i*16 + 0,  vmulq_u32(veorq_u32(h, j0), prime));
+        vst1q_u32(data_buf + i*16 + 4,  vmulq_u32(veorq_u32(h, j1), prime));
+        vst1q_u32(data_buf + i*16 + 8,  vmulq_u32(veorq_u32(h, j2), prime));
+        vst1q_u32(data_buf + i*16 + 12, vmulq_u32(veorq_u32(h, j3), prime));
+    }
+}
+#elif defined(__x86_64__) || defined(__i386__)
+// Generate Data Pattern (AVX2)
+// The 16 words of a column are computed as 2 vectors of 8 lanes (j).
+__attribute__((target("avx2")))
+static void gen_data_pattern_avx2(uint32_t *data_buf, uint32_t prefix) {
+    const __m256i prime = _mm256_set1_epi32((int)FNV_PRIME);
+    const __m256i j0 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i j1 = _mm256_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15);
+    for (uint32_t i = 0; i < 128; i++) {
+        __m256i h = _mm256_set1_epi32((int)((prefix ^ i) * FNV_PRIME));
+        _mm256_storeu_si256((__m256i *)(data_buf + i*16 + 0), _mm256_mullo_epi32(_mm256_xor_si256(h, j0), prime));
+        _mm256_storeu_si256((__m256i *)(data_buf + i*16 + 8), _mm256_mullo_epi32(_mm256_xor_si256(h, j1), prime));
+    }
+}
+
+// Generate Data Pattern (SSE4.1)
+// The 16 words of a column are computed as 4 vectors of 4 lanes (j).
+__attribute__((target("sse4.1")))
+static void gen_data_pattern_sse41(uint32_t *data_buf, uint32_t prefix) {
+    const __m128i prime = _mm_set1_epi32((int)FNV_PRIME);
+    const __m128i j0 = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i j1 = _mm_setr_epi32(4, 5, 6, 7);
+    const __m128i j2 = _mm_setr_epi32(8, 9, 10, 11);
+    const __m128i j3 = _mm_setr_epi32(12, 13, 14, 15);
+    for (uint32_t i = 0; i < 128; i++) {
+        __m128i h = _mm_set1_epi32((int)((prefix ^ i) * FNV_PRIME));
+        _mm_storeu_si128((__m128i *)(data_buf + i*16 + 0),  _mm_mullo_epi32(_mm_xor_si128(h, j0), prime));
+        _mm_storeu_si128((__m128i *)(data_buf + i*16 + 4),  _mm_mullo_epi32(_mm_xor_si128(h, j1), prime));
+        _mm_storeu_si128((__m128i *)(data_buf + i*16 + 8),  _mm_mullo_epi32(_mm_xor_si128(h, j2), prime));
+        _mm_storeu_si128((__m128i *)(data_buf + i*16 + 12), _mm_mullo_epi32(_mm_xor_si128(h, j3), prime));
+    }
+}
+#endif
+
+#if !defined(__ARM_NEON)
+// Generate Data Pattern (Hoisted Prefix, Scalar)
+static void gen_data_pattern_hoisted(uint32_t *data_buf, uint32_t prefix) {
+    for (uint32_t i = 0; i < 128; i++) {
+        uint32_t h = (prefix ^ i) * FNV_PRIME;
+        for (uint32_t j = 0; j < 16; j++) {
+            data_buf[i*16+j] = (h ^ j) * FNV_PRIME;
+        }
+    }
+}
+#endif
+
+// Generate Data Pattern
+// Bit-identical to gen_data_pattern_scalar. The row is written with full
+// vector stores in address order, so data_buf can be a DMA slot.
+void gen_data_pattern(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, uint32_t seed) {
+    uint32_t prefix = row_hash_prefix(bank_addr, row_addr, rank_addr, seed);
+#if defined(__ARM_NEON)
+    gen_data_pattern_neon(data_buf, prefix);
+#elif defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) {
+        gen_data_pattern_avx2(data_buf, prefix);
+    } else if (__builtin_cpu_supports("sse4.1")) {
+        gen_data_pattern_sse41(data_buf, prefix);
+    } else {
+        gen_data_pattern_hoisted(data_buf, prefix);
+    }
+#else
+    gen_data_pattern_hoisted(data_buf, prefix);
+#endif
+}
+
+// Generate Pattern (software reference of the in-fabric WR patterns)
+void gen_pattern(uint32_t *data_buf, uint8_t pattern_id, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, uint32_t seed) {
+    if (pattern_id == 1) {
+        gen_data_pattern(data_buf, bank_addr, row_addr, rank_addr, seed);
+        return;
+    }
+    for (uint32_t i = 0; i < 128; i++) {
+        for (uint32_t j = 0; j < 16; j++) {
+            uint32_t word;
+            switch (pattern_id) {
+                case 2:  word = seed; break;                                   // Solid
+                case 3:  word = ((row_addr ^ i ^ j) & 1) ? ~seed : seed; break; // Checkerboard
+                case 4:  word = (row_addr & 1) ? ~seed : seed; break;           // Row stripe
+                default: word = 0; break;
+            }
+            data_buf[i*16+j] = word;
+        }
+    }
+}
+
+// Record Flips (one mismatched word)
+static uint32_t record_flips(uint32_t expected, uint32_t actual, uint32_t word, flip_t *flips, uint32_t max_flips, uint32_t n_flips) {
+    uint32_t diff = expected ^ actual;
+    if (n_flips >= max_flips) {
+        return n_flips + __builtin_popcount(diff);
+    }
+    while (diff) {
+        uint32_t bit = __builtin_ctz(diff);
+        if (n_flips < max_flips) {
+            flips[n_flips].word = (uint16_t)word;
+            flips[n_flips].bit = (uint8_t)bit;
+            flips[n_flips].dir = (actual >> bit) & 1;
+        }
+        n_flips++;
+        diff &= diff - 1;
+    }
+    return n_flips;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Compare Row (AVX2)
+// Clean 16-word columns are skipped with two vector XOR/OR tests.
+__attribute__((target("avx2")))
+static uint32_t compare_row_avx2(const uint32_t *expected, const uint32_t *actual, flip_t *flips, uint32_t max_flips) {
+    uint32_t n_flips = 0;
+    for (uint32_t i = 0; i < 128; i++) {
+        __m256i d0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(expected + i*16 + 0)), _mm256_loadu_si256((const __m256i *)(actual + i*16 + 0)));
+        __m256i d1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(expected + i*16 + 8)), _mm256_loadu_si256((const __m256i *)(actual + i*16 + 8)));
+        __m256i d = _mm256_or_si256(d0, d1);
+        if (_mm256_testz_si256(d, d)) continue;
+        for (uint32_t j = 0; j < 16; j++) {
+            n_flips = record_flips(expected[i*16+j], actual[i*16+j], i*16+j, flips, max_flips, n_flips);
+        }
+    }
+    return n_flips;
+}
+#endif
+
+// Compare Row
+// Compares a row (16*128 words) and records every flipped bit: word index
+// (i*16+j), bit index and direction. At most max_flips records are stored;
+// the return value is the total number of flipped bits.
+uint32_t compare_row(const uint32_t *expected, const uint32_t *actual, flip_t *flips, uint32_t max_flips) {
+    uint32_t n_flips = 0;
+#if defined(__ARM_NEON)
+    // Clean 16-word columns are skipped with four vector XOR/OR tests
+    for (uint32_t i = 0; i < 128; i++) {
+        uint32x4_t d = veorq_u32(vld1q_u32(expected + i*16 + 0), vld1q_u32(actual + i*16 + 0));
+        d = vorrq_u32(d, veorq_u32(vld1q_u32(expected + i*16 + 4), vld1q_u32(actual + i*16 + 4)));
+        d = vorrq_u32(d, veorq_u32(vld1q_u32(expected + i*16 + 8), vld1q_u32(actual + i*16 + 8)));
+        d = vorrq_u32(d, veorq_u32(vld1q_u32(expected + i*16 + 12), vld1q_u32(actual + i*16 + 12)));
+#if defined(__aarch64__)
+        if (vmaxvq_u32(d) == 0) continue;
+#else
+        // ARMv7 NEON has no across-vector max: two pairwise steps
+        uint32x2_t m = vpmax_u32(vget_low_u32(d), vget_high_u32(d));
+        m = vpmax_u32(m, m);
+        if (vget_lane_u32(m, 0) == 0) continue;
+#endif
+        for (uint32_t j = 0; j < 16; j++) {
+            n_flips = record_flips(expected[i*16+j], actual[i*16+j], i*16+j, flips, max_flips, n_flips);
+        }
+    }
+#else
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) {
+        return compare_row_avx2(expected, actual, flips, max_flips);
+    }
+#endif
+    // Clean words are skipped 64 bits at a time
+    for (uint32_t w = 0; w < 16*128; w += 2) {
+        uint64_t e, a;
+        memcpy(&e, expected + w, sizeof(e));
+        memcpy(&a, actual + w, sizeof(a));
+        if (e == a) continue;
+        n_flips = record_flips(expected[w], actual[w], w, flips, max_flips, n_flips);
+        n_flips = record_flips(expected[w+1], actual[w+1], w+1, flips, max_flips, n_flips);
+    }
+#endif
+    return n_flips;
+}
@@ -3,10 +3,20 @@
 
 #include <stdint.h>
 
+// Bit Flip Record
+typedef struct {
+    uint16_t word; // Word index in the row (RD index * 16 + word in the 512-bit burst)
+    uint8_t bit;   // Bit index in the word
+    uint8_t dir;   // 1: 0->1, 0: 1->0
+} flip_t;
+
 uint32_t write_row(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr);
 uint32_t read_row(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr);
 uint32_t all_bank_refresh(uint8_t rank_addr);
 
+void gen_data_pattern_scalar(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, uint32_t seed);
 void gen_data_pattern(uint32_t *data_buf, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, uint32_t seed);
+void gen_pattern(uint32_t *data_buf, uint8_t pattern_id, uint8_t bank_addr, uint32_t row_addr, uint8_t rank_addr, uint32_t seed);
+uint32_t compare_row(const uint32_t *expected, const uint32_t *actual, flip_t *flips, uint32_t max_flips);
 
 #endif